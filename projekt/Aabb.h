@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Axis aligned bounding box, min and max corner
+struct Aabb {
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+
+	static Aabb from_center(const glm::vec3& center, const glm::vec3& size) {
+		return Aabb{ center - size * 0.5f, center + size * 0.5f };
+	}
+
+	// open intervals, touching boxes do not overlap (same as App::checkCollision)
+	bool overlaps(const Aabb& o) const {
+		return min.x < o.max.x && max.x > o.min.x &&
+			min.y < o.max.y && max.y > o.min.y &&
+			min.z < o.max.z && max.z > o.min.z;
+	}
+	bool contains(const Aabb& o) const {
+		return min.x <= o.min.x && min.y <= o.min.y && min.z <= o.min.z &&
+			max.x >= o.max.x && max.y >= o.max.y && max.z >= o.max.z;
+	}
+	Aabb merged(const Aabb& o) const { return Aabb{ glm::min(min, o.min), glm::max(max, o.max) }; }
+	Aabb expanded(float margin) const { return Aabb{ min - glm::vec3(margin), max + glm::vec3(margin) }; }
+	glm::vec3 center(void) const { return (min + max) * 0.5f; }
+	glm::vec3 size(void) const { return max - min; }
+	float surface_area(void) const {
+		glm::vec3 d = max - min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+};
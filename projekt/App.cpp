@@ -4,6 +4,7 @@
 #include <iostream>
 #include <filesystem>
 #include <algorithm>
+#include <cmath>
 #include <random>
 
 #include <glm/glm.hpp>
@@ -130,59 +131,56 @@ void App::init_gl_debug()
 
 void App::init_assets(void)
 {
-	// set player bounding box dimensions
-	playerObject.dimensions = glm::vec3(0.5);
-
-	// texture loading
-	GLuint texture_box = loadTexture("resources/textures/box_rgb888.png");
-	GLuint texture_floor = loadTexture("resources/textures/pavement.jpg");
-	GLuint texture_final_box = loadTexture("resources/textures/window.png");
-	GLuint texture_bunny = loadTexture("resources/textures/brick_wall-red.png");
-	GLuint texture_teapot = loadTexture("resources/textures/green_metal_rust.jpg");
-	GLuint texture_flipcow = loadTexture("resources/textures/factory_wall_diff_4k.jpg");
-
 	// Scene creation
-	scene["bunny"].mesh = Mesh("resources/shaders/obj.vert", "resources/shaders/obj.frag", "resources/models/bunny_tri_vnt.obj");
-	scene["bunny"].position = glm::vec3(0, 2, 0);
-	scene["bunny"].dimensions = scene["bunny"].mesh.calculateDimensions(0.2f);
-	scene["bunny"].mesh.model_matrix = glm::scale(glm::translate(glm::identity<glm::mat4>(), scene["bunny"].position), glm::vec3(0.2f));
-	scene["bunny"].mesh.specular_material = glm::vec4(glm::vec3(0.8), 1.0);
-	scene["bunny"].mesh.shininess = 32.0f;
-	scene["bunny"].mesh.texture = texture_bunny;
-
-	scene["teapot"].mesh = Mesh("resources/shaders/obj.vert", "resources/shaders/obj.frag", "resources/models/teapot_tri_vnt.obj");
-	scene["teapot"].position = glm::vec3(0, 2, 5);
-	scene["teapot"].dimensions = scene["teapot"].mesh.calculateDimensions(0.2);
-	scene["teapot"].mesh.model_matrix = glm::scale(glm::translate(glm::identity<glm::mat4>(), scene["teapot"].position), glm::vec3(0.2f));
-	scene["teapot"].mesh.specular_material = glm::vec4(glm::vec3(0.8), 1.0);
-	scene["teapot"].mesh.shininess = 32.0f;
-	scene["teapot"].mesh.texture = texture_teapot;
-
-	scene["suzanne"].mesh = Mesh("resources/shaders/obj.vert", "resources/shaders/obj.frag", "resources/models/suzanne.obj");
-	scene["suzanne"].position = glm::vec3(7, 4, 9);
-	scene["suzanne"].dimensions = scene["suzanne"].mesh.calculateDimensions(0.2);
-	scene["suzanne"].mesh.model_matrix = glm::scale(glm::translate(glm::identity<glm::mat4>(), scene["suzanne"].position), glm::vec3(0.5f));
-	scene["suzanne"].mesh.specular_material = glm::vec4(glm::vec3(0.8), 1.0);
-	scene["suzanne"].mesh.shininess = 32.0f;
-	scene["suzanne"].mesh.texture = texture_flipcow;
-
-	scene["plane"].mesh = Mesh("resources/shaders/obj.vert", "resources/shaders/obj.frag", "resources/models/plane_tri_vnt.obj");
-	scene["plane"].position = glm::vec3(5, 0, 5);
-	scene["plane"].dimensions = scene["plane"].mesh.calculateDimensions();
-	scene["plane"].mesh.model_matrix = glm::scale(glm::translate(glm::identity<glm::mat4>(), scene["plane"].position), glm::vec3(1.f));
-	scene["plane"].mesh.specular_material = glm::vec4(glm::vec3(0.8), 1.0);
-	scene["plane"].mesh.shininess = 1.0f;
-	scene["plane"].mesh.texture = texture_floor;
+	const char* obj_vert = "resources/shaders/obj.vert";
+	const char* obj_frag = "resources/shaders/obj.frag";
+
+	bunny_entity = entities.create(std::make_unique<Mesh>(obj_vert, obj_frag, "resources/models/bunny_tri_vnt.obj"), "bunny");
+	std::uint32_t i = entities.slot(bunny_entity);
+	entities.position[i] = glm::vec3(0, 2, 0);
+	entities.scale[i] = glm::vec3(0.2f);
+	entities.dimensions[i] = entities.mesh[i]->calculateDimensions(0.2f);
+	entities.simulated[i] = 1;
+	entities.velocity[i] = glm::vec3(superSpeed, superSpeed, 0.0f);
+	entities.mesh[i]->specular_material = glm::vec4(glm::vec3(0.8), 1.0);
+	entities.mesh[i]->shininess = 32.0f;
+	setTexture(*entities.mesh[i], "resources/textures/brick_wall-red.png");
+
+	i = entities.slot(entities.create(std::make_unique<Mesh>(obj_vert, obj_frag, "resources/models/teapot_tri_vnt.obj"), "teapot"));
+	entities.position[i] = glm::vec3(0, 2, 5);
+	entities.scale[i] = glm::vec3(0.2f);
+	entities.dimensions[i] = entities.mesh[i]->calculateDimensions(0.2f);
+	entities.simulated[i] = 1;
+	entities.spin[i] = glm::vec4(glm::normalize(glm::vec3(0.0f, 1.0f, 1.0f)), rotationAngle);
+	entities.mesh[i]->specular_material = glm::vec4(glm::vec3(0.8), 1.0);
+	entities.mesh[i]->shininess = 32.0f;
+	setTexture(*entities.mesh[i], "resources/textures/green_metal_rust.jpg");
+
+	i = entities.slot(entities.create(std::make_unique<Mesh>(obj_vert, obj_frag, "resources/models/suzanne.obj"), "suzanne"));
+	entities.position[i] = glm::vec3(7, 4, 9);
+	entities.dimensions[i] = entities.mesh[i]->calculateDimensions(0.2f);
+	entities.simulated[i] = 1;
+	entities.velocity[i] = glm::vec3(0.0f, 0.0f, superSpeed);
+	entities.mesh[i]->specular_material = glm::vec4(glm::vec3(0.8), 1.0);
+	entities.mesh[i]->shininess = 32.0f;
+	setTexture(*entities.mesh[i], "resources/textures/factory_wall_diff_4k.jpg");
+
+	i = entities.slot(entities.create(std::make_unique<Mesh>(obj_vert, obj_frag, "resources/models/plane_tri_vnt.obj"), "plane"));
+	entities.position[i] = glm::vec3(5, 0, 5);
+	entities.dimensions[i] = entities.mesh[i]->calculateDimensions();
+	entities.mesh[i]->specular_material = glm::vec4(glm::vec3(0.8), 1.0);
+	entities.mesh[i]->shininess = 1.0f;
+	setTexture(*entities.mesh[i], "resources/textures/pavement.jpg");
 
 	auto temp_cube = Mesh("resources/shaders/obj.vert", "resources/shaders/obj.frag", "resources/models/cube_triangles_normals_tex.obj");
-	temp_cube.texture = texture_box;
+	setTexture(temp_cube, "resources/textures/box_rgb888.png");
 
 	auto end_cube = Mesh("resources/shaders/obj.vert", "resources/shaders/obj.frag", "resources/models/cube_triangles_normals_tex.obj");
-	end_cube.texture = texture_final_box;
-	std::string end_cube_identification;
+	setTexture(end_cube, "resources/textures/window.png");
 
+	// walls and floor never move, their static lighting is baked
+	std::vector<Mesh*> static_meshes{ entities.mesh[entities.slot(entities.find("plane"))].get() };
 
-	std::string key_val;
 	//Labyrinth build
 	for (auto cols = 0; cols < mapa.cols; ++cols) {
 		for (auto rows = 0; rows < mapa.rows; ++rows) {
@@ -191,65 +189,141 @@ void App::init_assets(void)
 					break;
 				case 'e':
 					end_cube.specular_material = glm::vec4(1.0);
+					end_cube.transparent = true; // window texture, drawn after opaque objects
 					end_cube.shininess = 0.5f;
-					end_cube.model_matrix = glm::translate(glm::identity<glm::mat4>(), glm::vec3(cols, 0.5f, rows));
-					end_cube_identification = std::string("bedna konec");
-					scene[end_cube_identification].mesh = end_cube;
-					scene[end_cube_identification].position = glm::vec3(cols, 0.5f, rows);
-					scene[end_cube_identification].dimensions = scene[end_cube_identification].mesh.calculateDimensions();
+					i = entities.slot(entities.create(std::make_unique<Mesh>(end_cube), "bedna konec"));
+					entities.position[i] = glm::vec3(cols, 0.5f, rows);
+					entities.dimensions[i] = entities.mesh[i]->calculateDimensions();
 					break;
 				case 'X':
 					// player starting position
 					break;
 				case '#':
-					key_val = std::string("bedna ").append(std::to_string(cols).append(";").append(std::to_string(rows)));
 					temp_cube.specular_material = glm::vec4(glm::vec3(0.8), 1.0);
 					temp_cube.shininess = 0.5f;
-					temp_cube.model_matrix = glm::translate(glm::identity<glm::mat4>(), glm::vec3(cols, 0.5f, rows));
-					scene[key_val].mesh = temp_cube;
-					scene[key_val].position = glm::vec3(cols, 0.5f, rows);
-					scene[key_val].dimensions = scene[key_val].mesh.calculateDimensions();
+					// walls are not named, nothing looks them up
+					i = entities.slot(entities.create(std::make_unique<Mesh>(temp_cube)));
+					entities.position[i] = glm::vec3(cols, 0.5f, rows);
+					entities.dimensions[i] = entities.mesh[i]->calculateDimensions();
+					static_meshes.push_back(entities.mesh[i].get());
 					break;
 				default:
 					break;
 			}
 		}
 	}
+
+	// static objects into the collision grid, one cell per maze map cell; moving ones into the dynamic tree
+	std::vector<Aabb> static_boxes;
+	std::vector<std::uint32_t> static_slots;
+	for (std::uint32_t m = 0; m < entities.size(); ++m) {
+		if (entities.simulated[m]) {
+			moving_slots.push_back(m);
+			moving_proxies.push_back(moving_tree.insert(Aabb::from_center(entities.position[m], entities.dimensions[m]), m));
+			continue;
+		}
+		static_boxes.push_back(Aabb::from_center(entities.position[m], entities.dimensions[m]));
+		static_slots.push_back(m);
+	}
+	collision_grid.build(glm::vec2(-0.5f), mapa.cols, mapa.rows, 1.0f, static_boxes, static_slots);
+	maze_raycaster.build(glm::vec2(-0.5f), mapa.cols, mapa.rows, 1.0f, static_boxes, static_slots);
+
+	// one transform node per entity; walls and floor are computed here once and never again
+	for (std::uint32_t m = 0; m < entities.size(); ++m) {
+		entities.transform[m] = transforms.create();
+		transforms.set_local(entities.transform[m], entities.position[m], entities.orientation[m], entities.scale[m]);
+	}
+	// flashlight held a bit right of and below the eye
+	camera_node = transforms.create();
+	flashlight_node = transforms.create(camera_node);
+	transforms.set_position(flashlight_node, glm::vec3(0.15f, -0.15f, 0.0f));
+	transforms.update();
+	for (std::uint32_t m = 0; m < entities.size(); ++m)
+		entities.mesh[m]->model_matrix = transforms.world(entities.transform[m]);
+
+	// all layers known, upload the array texture; it is not managed, its bytes come off the VRAM budget
+	texture_array.build();
+	texture_manager.set_budget(texture_manager.budget() - std::min(texture_manager.budget(), texture_array.byte_cost()));
+
+	// Lights: the former single point light above the scene, then torches along the maze walls
+	PointLight sky_light;
+	sky_light.position = glm::vec3(5.0f, 10.0f, 5.0f);
+	sky_light.color = glm::vec3(0.5f);
+	sky_light.ambient = 1.0f;
+	sky_light.radius = 40.0f;
+	sky_light.baked = true;
+	lights.add(sky_light);
+
+	const glm::ivec2 wall_directions[4] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+	for (auto cols = 1; cols < mapa.cols - 1; ++cols) {
+		for (auto rows = 1; rows < mapa.rows - 1; ++rows) {
+			if (getmap(mapa, cols, rows) == '#' || (cols + rows) % 2 != 0)
+				continue;
+			for (const glm::ivec2& dir : wall_directions) {
+				if (getmap(mapa, cols + dir.x, rows + dir.y) != '#')
+					continue;
+				// on the wall face, above head height of the cubes
+				PointLight torch;
+				torch.position = glm::vec3(cols + dir.x * 0.4f, 0.8f, rows + dir.y * 0.4f);
+				torch.color = glm::vec3(1.0f, 0.6f, 0.25f);
+				torch.ambient = 0.05f;
+				torch.radius = 2.5f;
+				lights.add(torch);
+				break;
+			}
+		}
+	}
+
+	// bake or load static lighting, only torches and flashlight stay per-pixel on walls and floor
+	std::vector<PointLight> point_lights;
+	for (std::size_t i = 0; i < lights.light_count(); ++i)
+		point_lights.push_back(lights.light(i));
+	lightmap.build(static_meshes, point_lights, maze_seed);
+
+	// every object gets a slot in the per-object SSBO
+	for (auto& mesh : entities.mesh)
+		object_buffer.add(*mesh);
+	frame_stream.reserve(object_buffer.bytes_per_frame());
+
+	// GPU-driven path gets all opaque objects, transparent ones stay in the render queue
+	std::vector<Mesh*> opaque_meshes;
+	for (auto& mesh : entities.mesh)
+		if (!mesh->transparent)
+			opaque_meshes.push_back(mesh.get());
+	indirect_renderer.init();
+	depth_shader = ShaderProgram("resources/shaders/depth.vert", "resources/shaders/depth.frag");
+	dynamic_resolution.init();
+
+	// sun shadows: maze cached, moving objects per frame
+	sun_shadows.init();
+	sun_shadows.set_static(static_meshes);
+	std::vector<Mesh*> moving_meshes;
+	for (std::uint32_t m = 0; m < entities.size(); ++m)
+		if (entities.simulated[m])
+			moving_meshes.push_back(entities.mesh[m].get());
+	sun_shadows.set_dynamic(moving_meshes);
+	indirect_renderer.build(opaque_meshes);
 }
 
-GLuint App::loadTexture(char const* path)
+void App::setTexture(Mesh& mesh, char const* path)
 {
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format{};
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
+	// compatible textures share one array texture, mesh keeps only the layer
+	if (use_texture_array) {
+		int layer = texture_array.add(path);
+		if (layer >= 0) {
+			mesh.texture_layer = layer;
+			return;
+		}
 	}
+	mesh.texture = loadTexture(path);
+}
+
+GLuint App::loadTexture(char const* path)
+{
+	// decoded and mipmapped only on first use, shared between users of the same file
+	GLuint textureID = texture_manager.acquire(path, texture_import_settings);
+	if (textureID == 0)
+		glGenTextures(1, &textureID); // keep old behaviour, empty texture for missing file
 
 	return textureID;
 }
@@ -349,25 +423,215 @@ void App::update_projection_matrix(void)
 	);
 }
 
+// Simulation thread: fixed steps of 1 / sim_hz on a real time grid, one snapshot per step
+void App::simulation_thread_code(void)
+{
+	using clock = std::chrono::steady_clock;
+	const auto step = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / sim_hz));
+	const GLfloat dt = static_cast<GLfloat>(1.0 / sim_hz);
+	auto next_step = clock::now();
+
+	// an exception must not leave the thread, the render thread rethrows it
+	try {
+		while (!sim_should_end) {
+			int steps = 0;
+			while (clock::now() >= next_step && steps < max_sim_steps) {
+				SimInput input;
+				{
+					std::scoped_lock lock(sim_input_mutex);
+					input = sim_input;
+				}
+
+				FrameSnapshot& snap = snapshots.write_buffer();
+				snap.previous_camera_position = sim_camera.Position;
+				snap.objects.clear();
+				for (std::uint32_t i = 0; i < entities.size(); ++i)
+					if (entities.simulated[i])
+						snap.objects.push_back({ entities.mesh[i].get(), i, entities.position[i], {}, entities.orientation[i], {}, {} });
+
+				bool animate = sim_animate;
+				simulate_step(dt, input, animate);
+				if (animate)
+					sim_time += dt;
+
+				snap.step_time = next_step;
+				publish_snapshot(input);
+
+				next_step += step;
+				++steps;
+			}
+			sim_steps += steps;
+
+			// too far behind: drop the backlog instead of spending the next wake-ups catching up
+			auto now = clock::now();
+			if (now >= next_step) {
+				sim_dropped += static_cast<unsigned int>((now - next_step) / step) + 1;
+				next_step = now + step;
+			}
+
+			std::this_thread::sleep_until(next_step);
+		}
+	}
+	catch (...) {
+		sim_error = std::current_exception();
+		sim_failed = true;
+		glfwPostEmptyEvent(); // wake the render thread when it waits for events
+	}
+}
+
+// complete the snapshot prepared in write_buffer() with the state after the step and hand it over
+void App::publish_snapshot(const SimInput& input)
+{
+	FrameSnapshot& snap = snapshots.write_buffer();
+	snap.sequence = sim_published + 1;
+	snap.sim_time = sim_time;
+	snap.input_time = input.sampled;
+	snap.camera_position = sim_camera.Position;
+	snap.moved = snap.camera_position != snap.previous_camera_position;
+	for (auto& o : snap.objects) {
+		o.position = entities.position[o.slot];
+		o.orientation = entities.orientation[o.slot];
+		o.scale = entities.scale[o.slot];
+		snap.moved |= o.position != o.previous_position || o.orientation != o.previous_orientation;
+	}
+	snapshots.publish();
+	sim_published = snap.sequence;
+
+	// wake the render thread when it waits for events
+	if (snap.moved) {
+		sim_last_moved = snap.sequence;
+		glfwPostEmptyEvent();
+	}
+}
+
+// one step of 1 / sim_hz: player movement with collisions and moving objects
+// runs on the simulation thread; touches sim_camera and transform/motion components of simulated entities only
+void App::simulate_step(GLfloat dt, const SimInput& input, bool animate)
+{
+	// movement from the keys sampled by the render thread, same priority as Camera::ProcessInputPoll
+	sim_camera.Front = input.front;
+	sim_camera.Right = input.right;
+	sim_camera.Up = input.up;
+	glm::vec3 offset = glm::vec3(0.0f);
+	for (int d = 0; d < 6; ++d) {
+		if (input.keys[d]) {
+			offset = sim_camera.ProcessInput(static_cast<Camera::direction>(d), dt);
+			break;
+		}
+	}
+
+	// cannot move into negative position on the y axis
+	if (sim_camera.Position.y + offset.y < 0.0f + sim_camera.camera_height)
+		offset.y = sim_camera.camera_height - sim_camera.Position.y;
+
+	// Moving Objects - update object positions, paused while rendering on demand
+	if (animate) {
+		process_object_movement(dt);
+		update_broadphase();
+	}
+
+	// what the player looks at
+	GridRaycaster::Ray view;
+	view.origin = sim_camera.Position;
+	view.direction = input.front;
+	view.max_distance = 50.0f;
+	GridRaycaster::Hit seen = raycast(view);
+	looked_at = seen.id;
+	looked_at_distance = seen.distance;
+	looked_at_cells = seen.cells;
+
+	if (offset == glm::vec3(0.0f))
+		return;
+
+	// collision: candidates around the whole move, static objects from the grid cells, moving objects from the tree;
+	// the controller sweeps the player box against them and slides along the walls it hits
+	Aabb reach = player_controller.swept_box(sim_camera.Position, player_dimensions, offset);
+	collision_candidates.clear();
+	auto gather = [&](std::uint32_t i) {
+		collision_candidates.push_back(Aabb::from_center(entities.position[i], entities.dimensions[i]));
+	};
+	collision_grid.query(reach, gather);
+	moving_tree.query(reach, [&](std::int32_t proxy) { gather(moving_tree.user(proxy)); });
+
+	CharacterController::Result moved = player_controller.move(sim_camera.Position, player_dimensions, offset, collision_candidates);
+	sim_camera.Position = moved.position;
+
+	collision_queries++;
+	collision_tests += static_cast<unsigned int>(collision_candidates.size());
+	collision_contacts += moved.contacts;
+}
+
+// closest entity along a ray: static ones by walking the maze cells, the few moving ones directly
+GridRaycaster::Hit App::raycast(const GridRaycaster::Ray& ray)
+{
+	GridRaycaster::Hit hit = maze_raycaster.raycast(ray);
+	for (std::uint32_t i : moving_slots) {
+		float distance;
+		glm::vec3 normal;
+		hit.tests++;
+		if (GridRaycaster::intersect(Aabb::from_center(entities.position[i], entities.dimensions[i]), ray, distance, normal)
+			&& (!hit.hit() || distance < hit.distance)) {
+			hit.id = i;
+			hit.distance = distance;
+			hit.normal = normal;
+		}
+	}
+	return hit;
+}
+
+// moves the tree proxies of the moving entities and finds their contacts with each other and the static scene
+void App::update_broadphase(void)
+{
+	unsigned int reinserts = 0;
+	for (std::size_t k = 0; k < moving_slots.size(); ++k) {
+		std::uint32_t i = moving_slots[k];
+		if (moving_tree.move(moving_proxies[k], Aabb::from_center(entities.position[i], entities.dimensions[i])))
+			++reinserts;
+	}
+#ifdef _DEBUG
+	moving_tree.validate();
+#endif
+
+	// fat boxes give the candidates, the exact boxes decide; nothing reacts to contacts yet, they are counted
+	unsigned int pairs = 0, statics = 0;
+	moving_tree.query_pairs([&](std::int32_t a, std::int32_t b) {
+		std::uint32_t i = moving_tree.user(a), j = moving_tree.user(b);
+		if (checkCollision(entities.position[i], entities.dimensions[i], entities.position[j], entities.dimensions[j]))
+			++pairs;
+	});
+	for (std::uint32_t i : moving_slots) {
+		collision_grid.query(Aabb::from_center(entities.position[i], entities.dimensions[i]), [&](std::uint32_t s) {
+			if (checkCollision(entities.position[i], entities.dimensions[i], entities.position[s], entities.dimensions[s]))
+				++statics;
+		});
+	}
+	broad_reinserts += reinserts;
+	broad_pairs += pairs;
+	broad_static_contacts += statics;
+	broad_height = moving_tree.height();
+}
+
+// advances positions and orientations only, model matrices are built from them when rendering
 void App::process_object_movement(GLfloat deltaTime){
-	// Moving Objects
-	// Bunny - Moving
+	// Moving Objects - one pass over the motion components, velocities follow the bunny's direction
 	float movementDirection = (endPosBool) ? 1.0f : -1.0f;
-	scene["bunny"].position.x += movementDirection * superSpeed * glm::abs(deltaTime);
-	scene["bunny"].position.y += movementDirection * superSpeed * glm::abs(deltaTime);
-	scene["bunny"].mesh.model_matrix = glm::scale(glm::translate(glm::identity<glm::mat4>(), scene["bunny"].position), glm::vec3(0.2f));
+	for (std::uint32_t i = 0; i < entities.size(); ++i) {
+		if (!entities.simulated[i])
+			continue;
+		entities.position[i] += movementDirection * entities.velocity[i] * glm::abs(deltaTime);
+		// rotation from the wrapped angle, so no error accumulates
+		if (entities.spin[i].w != 0.0f) {
+			entities.spin_angle[i] = std::fmod(entities.spin_angle[i] + entities.spin[i].w * glm::abs(deltaTime), 360.0f);
+			entities.orientation[i] = glm::angleAxis(glm::radians(entities.spin_angle[i]), glm::vec3(entities.spin[i]));
+		}
+	}
 
-	if ((endPosBool && scene["bunny"].position.x >= bunnyPositiveCap) ||
-		(!endPosBool && scene["bunny"].position.x <= bunnyNegativeCap)) {
+	// End position
+	float bunny_x = entities.position[entities.slot(bunny_entity)].x;
+	if ((endPosBool && bunny_x >= bunnyPositiveCap) ||
+		(!endPosBool && bunny_x <= bunnyNegativeCap)) {
 		endPosBool = !endPosBool;
 	}
-	// Teapot - Rotation
-	//trans = glm::rotate(ma4_for_rotation, angle_in_radians, glm::vec3(0.0f, 0.0f, 1.0f) - osy rotace);
-	scene["teapot"].mesh.model_matrix = glm::rotate(scene["teapot"].mesh.model_matrix, glm::radians(rotationAngle * glm::abs(deltaTime)), glm::vec3(0.0f, 1.0f, 1.0f));
-
-	// Suzanne - moving
-	scene["suzanne"].position.z += movementDirection * superSpeed * glm::abs(deltaTime);
-	scene["suzanne"].mesh.model_matrix = glm::translate(glm::identity<glm::mat4>(), scene["suzanne"].position);
 }
 
 void App::toggleFullscreen(GLFWwindow* window)
@@ -400,60 +664,41 @@ uchar App::getmap(cv::Mat& map, int x, int y)
 	return map.at<uchar>(y, x);
 }
 
-// Random map gen
+// Random perfect maze: start in a random cell, end in the cell furthest from it
 void App::genLabyrinth(cv::Mat& map) {
 	cv::Point2i start_position, end_position;
 
 	// C++ random numbers
-	std::random_device r; // Seed with a real random value, if available
-	std::default_random_engine e1(r());
-	std::uniform_int_distribution<int> uniform_height(1, map.rows - 2); // uniform distribution between int..int
-	std::uniform_int_distribution<int> uniform_width(1, map.cols - 2);
-	std::uniform_int_distribution<int> uniform_block(0, 7); // how often are walls generated: 0=wall, anything else=empty
-
-	//inner maze 
-	for (int j = 0; j < map.rows; j++) {
-		for (int i = 0; i < map.cols; i++) {
-			switch (uniform_block(e1))
-			{
-			case 0:
-				map.at<uchar>(cv::Point(i, j)) = '#';
-				break;
-			default:
-				map.at<uchar>(cv::Point(i, j)) = '.';
-				break;
-			}
-		}
+	if (maze_seed == 0) {
+		std::random_device r; // Seed with a real random value, if available
+		maze_seed = r();
 	}
-
-	//walls
-	for (int i = 0; i < map.cols; i++) {
-		map.at<uchar>(cv::Point(i, 0)) = '#';
-		map.at<uchar>(cv::Point(i, map.rows - 1)) = '#';
-	}
-	for (int j = 0; j < map.rows; j++) {
-		map.at<uchar>(cv::Point(0, j)) = '#';
-		map.at<uchar>(cv::Point(map.cols - 1, j)) = '#';
-	}
-
-	//gen start_position inside maze (excluding walls)
-	do {
-		start_position.x = uniform_width(e1);
-		start_position.y = uniform_height(e1);
-	} while (getmap(map, start_position.x, start_position.y) == '#'); //check wall
-
-	//gen end different from start, inside maze (excluding outer walls) 
-	do {
-		end_position.x = uniform_width(e1);
-		end_position.y = uniform_height(e1);
-	} while (start_position == end_position); //check overlap
+	std::cout << "Maze seed: " << maze_seed << ", " << MazeGenerator::name(maze_algorithm) << ' ' << maze_cells << 'x' << maze_cells << std::endl;
+	Maze maze = MazeGenerator::generate(maze_algorithm, maze_cells, maze_cells, maze_seed);
+
+	// cells and the passages between them become floor blocks
+	map.create(2 * maze.height() + 1, 2 * maze.width() + 1, CV_8U);
+	for (int j = 0; j < map.rows; j++)
+		for (int i = 0; i < map.cols; i++)
+			map.at<uchar>(cv::Point(i, j)) = maze.wall(i, j) ? '#' : '.';
+
+	// the furthest cell found by BFS is reachable by construction, the check guards the generators
+	std::mt19937 e1(maze_seed);
+	std::uint32_t start = e1() % maze.cell_count();
+	int steps = 0;
+	std::uint32_t end = maze.farthest(start, steps);
+	if (!maze.connected() || maze.distance(start, end) != steps)
+		throw std::exception("genLabyrinth: generated maze is not solvable");
+
+	start_position = cv::Point2i(2 * static_cast<int>(start % maze.width()) + 1, 2 * static_cast<int>(start / maze.width()) + 1);
+	end_position = cv::Point2i(2 * static_cast<int>(end % maze.width()) + 1, 2 * static_cast<int>(end / maze.width()) + 1);
 	map.at<uchar>(cv::Point(end_position.x, end_position.y)) = 'e';
 
 	std::cout << "Start: " << start_position << std::endl;
-	std::cout << "End: " << end_position << std::endl;
+	std::cout << "End: " << end_position << ", " << steps << " cells away" << std::endl;
 
-	//print map
-	for (int j = 0; j < map.rows; j++) {
+	//print map, if it fits a console
+	for (int j = 0; j < map.rows && map.cols <= 120; j++) {
 		for (int i = 0; i < map.cols; i++) {
 			if ((i == start_position.x) && (j == start_position.y))
 				std::cout << 'X';
@@ -469,26 +714,34 @@ void App::genLabyrinth(cv::Mat& map) {
 	camera.Position.y = camera.camera_height;
 }
 
-bool App::checkCollision(const GameObject& obj1, const GameObject& obj2){
-	return (
-		obj1.position.x - obj1.dimensions.x / 2 < obj2.position.x + obj2.dimensions.x / 2 &&
-		obj1.position.x + obj1.dimensions.x / 2 > obj2.position.x - obj2.dimensions.x / 2 &&
-		obj1.position.y - obj1.dimensions.y / 2 < obj2.position.y + obj2.dimensions.y / 2 &&
-		obj1.position.y + obj1.dimensions.y / 2 > obj2.position.y - obj2.dimensions.y / 2 &&
-		obj1.position.z - obj1.dimensions.z / 2 < obj2.position.z + obj2.dimensions.z / 2 &&
-		obj1.position.z + obj1.dimensions.z / 2 > obj2.position.z - obj2.dimensions.z / 2
-		);
+bool App::checkCollision(const glm::vec3& position1, const glm::vec3& dimensions1, const glm::vec3& position2, const glm::vec3& dimensions2){
+	// twice the distance of the centers against the sum of the sizes, no divisions; many boxes at once: CollisionKernels
+	glm::vec3 distance = glm::abs(position1 - position2) * 2.0f;
+	glm::vec3 reach = dimensions1 + dimensions2;
+	return distance.x < reach.x && distance.y < reach.y && distance.z < reach.z;
 }
 
+// stops and joins a thread on every way out of run(), destroying a joinable std::thread terminates
+struct ThreadJoiner {
+	std::thread& thread;
+	std::atomic<bool>& should_end;
+	~ThreadJoiner() {
+		should_end = true;
+		if (thread.joinable())
+			thread.join();
+	}
+};
+
 int App::run(void)
 {
 	try {
 		int framecnt = 0;
-		double last_frame_time = glfwGetTime();
-		double last_framecnt_time = last_frame_time;
+		double last_framecnt_time = glfwGetTime();
+		std::uint64_t last_sequence = 0; // snapshot being rendered
 
 		// start thread 
 		std::thread tracker_thread(&App::tracker_thread_code, this);
+		ThreadJoiner tracker_joiner{ tracker_thread, thread_should_end };
 
 		glClearColor(clear_color.r, clear_color.g, clear_color.b, clear_color.a);
 		
@@ -511,131 +764,292 @@ int App::run(void)
 		lastX = width/2;
 		lastY = height/2;
 
-		// update position of player object to match camera's position
-		playerObject.position = camera.Position;
+
+		// array texture stays bound on unit 1 for the whole run
+		GLState::activeTexture(GL_TEXTURE1);
+		GLState::bindTexture(GL_TEXTURE_2D_ARRAY, texture_array.id());
+		// lightmap atlas pages on unit 2
+		GLState::activeTexture(GL_TEXTURE2);
+		GLState::bindTexture(GL_TEXTURE_2D_ARRAY, lightmap.id());
+		// shadow maps on units 3 and 4
+		GLState::activeTexture(SunShadows::static_unit);
+		GLState::bindTexture(GL_TEXTURE_2D, sun_shadows.static_texture());
+		GLState::activeTexture(SunShadows::dynamic_unit);
+		GLState::bindTexture(GL_TEXTURE_2D, sun_shadows.dynamic_texture());
+		GLState::activeTexture(GL_TEXTURE0);
+
+		// simulation runs ahead on its own thread, this thread renders its snapshots
+		sim_camera = camera;
+		{
+			std::scoped_lock lock(sim_input_mutex);
+			sim_input.front = camera.Front;
+			sim_input.right = camera.Right;
+			sim_input.up = camera.Up;
+			sim_input.sampled = std::chrono::steady_clock::now();
+		}
+		std::thread simulation_thread(&App::simulation_thread_code, this);
+		ThreadJoiner simulation_joiner{ simulation_thread, sim_should_end };
+		const double sim_dt = 1.0 / sim_hz;
 
 		cv::Point2f tracker_normalized_center{ 0 };
 		while (!glfwWindowShouldClose(window))
 		{
+			if (sim_failed)
+				std::rethrow_exception(sim_error);
+
+			// on-demand pacing: nothing changed, block in the event queue until input arrives
+			if (frame_limiter.mode == FrameLimiter::Mode::on_demand && !redraw_requested) {
+				glfwWaitEventsTimeout(frame_limiter.idle_timeout);
+				frame_limiter.reset();
+				if (!redraw_requested && fronta.empty() && sim_last_moved <= last_sequence)
+					continue;
+			}
+			redraw_requested = false;
+
 			// get new time
 			double now = glfwGetTime();
-			double delta_t = now - last_frame_time;
 
 			// thread related stuff
 			if (videoAvailable && !fronta.empty()) {
 				tracker_normalized_center = fronta.pop_front();
 				std::cout << '.';
+				redraw_requested |= trackFlashlight;
 			}
 
-			// process movement from keyboard, use poll method
-			glm::vec3 offset = camera.ProcessInputPoll(delta_t);
-
-			camera.Position.x += offset.x;
-			camera.Position.z += offset.z;
-			// cannot move into negative position on the y axis
-			if (camera.Position.y + offset.y < 0.0 + camera.camera_height) {
-				camera.Position.y = 0.0f + camera.camera_height;
-				offset.y = 0;
-			}
-			else {
-				camera.Position.y += offset.y;
+			// input for the simulation thread, movement keys and the current view direction
+			sim_animate = frame_limiter.mode != FrameLimiter::Mode::on_demand;
+			{
+				static constexpr int keys[6] = { GLFW_KEY_W, GLFW_KEY_S, GLFW_KEY_A, GLFW_KEY_D, GLFW_KEY_R, GLFW_KEY_F };
+				std::scoped_lock lock(sim_input_mutex);
+				for (int d = 0; d < 6; ++d)
+					sim_input.keys[d] = glfwGetKey(window, keys[d]) == GLFW_PRESS;
+				sim_input.front = camera.Front;
+				sim_input.right = camera.Right;
+				sim_input.up = camera.Up;
+				sim_input.sampled = std::chrono::steady_clock::now();
 			}
 
-			// Moving Objects - update object positions
-			process_object_movement(delta_t);
-
-			// update position of player object
-			playerObject.position = camera.Position;
-
-			// collision detection loop
-			for (auto& scene_object : scene) {
-				if (checkCollision(playerObject, scene_object.second)) {
-					// collision resolution - reverting movement
-					// better would be to calculate distance to perfect collision
-					camera.Position.x -= offset.x;
-					camera.Position.z -= offset.z;
-					camera.Position.y -= offset.y;
-					break;
-				}
+			// newest simulation snapshot, rendered one step behind so it can be interpolated
+			if (snapshots.update()) {
+				pipe_skipped += static_cast<unsigned int>(snapshots.read_buffer().sequence - last_sequence - 1);
+				last_sequence = snapshots.read_buffer().sequence;
+			}
+			pipe_behind += static_cast<unsigned int>(sim_published - last_sequence);
+			const FrameSnapshot& snap = snapshots.read_buffer();
+
+			float alpha = 1.0f;
+			glm::vec3 render_camera_position = camera.Position;
+			if (snap.sequence != 0) {
+				alpha = static_cast<float>(std::chrono::duration<double>(std::chrono::steady_clock::now() - snap.step_time).count() / sim_dt);
+				alpha = std::clamp(alpha, 0.0f, 1.0f);
+				for (auto const& o : snap.objects)
+					transforms.set_local(entities.transform[o.slot], o.position_at(alpha), o.orientation_at(alpha), o.scale);
+				render_camera_position = glm::mix(snap.previous_camera_position, snap.camera_position, alpha);
+				camera.Position = render_camera_position;
 			}
 
-			// update position of player object again after checking collisions
-			playerObject.position = camera.Position;
+			// keep rendering while the last step moved something and its interpolation is not done
+			if ((snap.moved && alpha < 1.0f) || xoffset != 0.0f || yoffset != 0.0f)
+				redraw_requested = true;
 
-			// process mouse movements
+			// process mouse movements, every frame for the lowest look latency
 			camera.ProcessMouseMovement(xoffset, yoffset);
 			xoffset = 0; yoffset = 0; // set offsets to zero to eliminate residual values
 
-			// OpenGL stuff...
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+			// OpenGL stuff... scene goes offscreen at the current render scale
+			dynamic_resolution.begin(width, height);
+
+			//view, from the interpolated position
+			glm::mat4 view_matrix = glm::lookAt(render_camera_position, render_camera_position + camera.Front, camera.Up);
 
-			//view
-			glm::mat4 view_matrix = camera.GetViewMatrix();
+			// camera node follows the view, the flashlight is its child
+			transforms.set_local(camera_node, render_camera_position, glm::quatLookAt(camera.Front, camera.Up), glm::vec3(1.0f));
 
-			//flashlight tracker
-			glm::vec3 flashLightDirection;
+			//flashlight tracker, turns the flashlight relative to the camera
+			glm::quat flashlight_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
 			if (videoAvailable && trackFlashlight) {
 				// calculate offset from the camera view based on the tracker position
-				float tracker_x = tracker_normalized_center.x;
-				float tracker_y = tracker_normalized_center.y;
-				float tracker_x_offset = 0.5 - tracker_x;
-				float tracker_y_offset = 0.5 - tracker_y;
-				// the ammount of tracker flashlight offset is dependent on fov
-				float tracker_yaw = camera.Yaw + (tracker_x_offset * fov_degrees);
-				float tracker_pitch = camera.Pitch + (tracker_y_offset * fov_degrees);
-
-				flashLightDirection.x = cos(glm::radians(tracker_yaw)) * cos(glm::radians(tracker_pitch));
-				flashLightDirection.y = sin(glm::radians(tracker_pitch));
-				flashLightDirection.z = sin(glm::radians(tracker_yaw)) * cos(glm::radians(tracker_pitch));
-
-				flashLightDirection = glm::normalize(flashLightDirection);
-
-				//check if result in NaN
-				if (std::isnan(flashLightDirection.x) || std::isnan(flashLightDirection.y) || std::isnan(flashLightDirection.z)){
-					flashLightDirection.x = camera.Front.x;
-					flashLightDirection.y = camera.Front.y;
-					flashLightDirection.z = camera.Front.z;
-				}
-			}else{
-				flashLightDirection.x = camera.Front.x;
-				flashLightDirection.y = camera.Front.y;
-				flashLightDirection.z = camera.Front.z;
-
+				float tracker_x_offset = 0.5f - tracker_normalized_center.x;
+				float tracker_y_offset = 0.5f - tracker_normalized_center.y;
+				// the ammount of tracker flashlight offset is dependent on fov; right is -yaw around local up
+				flashlight_rotation = glm::angleAxis(glm::radians(-tracker_x_offset * fov_degrees), glm::vec3(0.0f, 1.0f, 0.0f))
+					* glm::angleAxis(glm::radians(tracker_y_offset * fov_degrees), glm::vec3(1.0f, 0.0f, 0.0f));
+			}
+			transforms.set_rotation(flashlight_node, flashlight_rotation);
+
+			// world matrices of moved nodes only, static walls are skipped
+			transforms.update();
+			for (std::uint32_t m = 0; m < entities.size(); ++m)
+				if (transforms.changed(entities.transform[m]))
+					entities.mesh[m]->model_matrix = transforms.world(entities.transform[m]);
+
+			const glm::mat4& flashlight = transforms.world(flashlight_node);
+			glm::vec3 flashLightPosition = glm::vec3(flashlight[3]);
+			glm::vec3 flashLightDirection = glm::normalize(glm::vec3(flashlight * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f)));
+
+			// Fill render queue, order is decided by sort keys (state, depth, transparency)
+			render_queue.clear();
+			for (auto& entity_mesh : entities.mesh) {
+				Mesh& mesh = *entity_mesh;
+
+				// position from the model matrix, the simulation thread owns the transform components
+				glm::vec3 position = glm::vec3(mesh.model_matrix[3]);
+				float depth = -(view_matrix * glm::vec4(position, 1.0f)).z;
+				if (!gpu_driven || mesh.transparent)
+					render_queue.submit(mesh, depth);
+				texture_manager.mark_visible(mesh.texture, glm::distance(camera.Position, position));
+			}
+			render_queue.sort();
+
+			// torches flicker with simulation time, light 0 is the sky light
+			float light_time = static_cast<float>(snap.sim_time - (1.0f - alpha) * sim_dt);
+			for (std::size_t i = 1; i < lights.light_count(); ++i)
+				lights.light(i).intensity = 0.85f + 0.15f * glm::sin(light_time * 7.0f + i * 1.7f) * glm::sin(light_time * 3.1f + i);
+			lights.build(projection_matrix, view_matrix, dynamic_resolution.render_width(), dynamic_resolution.render_height());
+
+			// transforms, normal matrices, materials and lights, written into mapped memory
+			frame_stream.reserve(object_buffer.bytes_per_frame() + lights.bytes_per_frame() + sun_shadows.bytes_per_frame());
+			frame_stream.begin_frame();
+			object_buffer.update(view_matrix, frame_stream);
+			lights.upload(frame_stream);
+
+			// static map only when the maze changed, dynamic map every frame
+			sun_shadows.render(depth_shader, frame_stream);
+
+			// opaque objects culled on the GPU
+			if (gpu_driven)
+				indirect_renderer.cull(projection_matrix, view_matrix);
+
+			// depth pre-pass: lay down opaque depth, then shade only the visible fragment with GL_EQUAL
+			if (depth_prepass) {
+				depth_shader.activate();
+				depth_shader.setUniform("uPm", projection_matrix);
+				depth_shader.setUniform("uVm", view_matrix);
+				glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+				if (gpu_driven)
+					indirect_renderer.draw_depth();
+				for (auto const& cmd : render_queue.commands())
+					if (!cmd.mesh->transparent)
+						cmd.mesh->drawDepth();
+
+				glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+				glDepthFunc(GL_EQUAL);
+				glDepthMask(GL_FALSE);
 			}
 
-			// Draw all objects except end point ("bedna konec")
-			for (auto& scene_object : scene) {
-				if (scene_object.first != "bedna konec") 
-				{
-					scene_object.second.mesh.viewPos = camera.Position;
-					scene_object.second.mesh.flashLightDirection = flashLightDirection;
-					scene_object.second.mesh.draw(projection_matrix, view_matrix);
+			if (gpu_driven)
+				indirect_renderer.draw(projection_matrix, view_matrix, render_camera_position, flashLightPosition, flashLightDirection);
+
+			// per-frame uniforms once per program, the queue is sorted by program
+			GLuint frame_program = 0;
+			bool depth_restored = !depth_prepass;
+			for (auto const& cmd : render_queue.commands()) {
+				// blended objects come last and were not in the pre-pass
+				if (!depth_restored && cmd.mesh->transparent) {
+					glDepthFunc(GL_LESS);
+					glDepthMask(GL_TRUE);
+					depth_restored = true;
 				}
+				if (cmd.mesh->mesh_shader.getID() != frame_program) {
+					frame_program = cmd.mesh->mesh_shader.getID();
+					Mesh::setFrameUniforms(cmd.mesh->mesh_shader, projection_matrix, view_matrix, render_camera_position, flashLightPosition, flashLightDirection);
+				}
+				cmd.mesh->draw();
 			}
-
-			// Draw end point last - for correct transparency
-			auto end_point_iter = scene.find("bedna konec");
-			if (end_point_iter != scene.end()) 
-			{
-				end_point_iter->second.mesh.viewPos = camera.Position;
-				end_point_iter->second.mesh.flashLightDirection = flashLightDirection;
-				end_point_iter->second.mesh.draw(projection_matrix, view_matrix);
+			if (!depth_restored) {
+				glDepthFunc(GL_LESS);
+				glDepthMask(GL_TRUE);
 			}
 
+			// upscale to the window, GPU time feeds the scale of the next frames
+			dynamic_resolution.end();
+
+			// drop or restore mip levels to stay within VRAM budget
+			texture_manager.update();
+
+			// fence this frame's region of the stream buffer
+			frame_stream.end_frame();
+			GLState::endFrame();
+
+			// hold the frame until its deadline when limited
+			frame_limiter.wait();
+
 			glfwSwapBuffers(window);
+
+			// input to present: the snapshot was simulated from input sampled that long ago
+			if (snap.sequence != 0) {
+				double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - snap.input_time).count();
+				pipe_latency_ms += latency;
+				pipe_latency_max_ms = std::max(pipe_latency_max_ms, latency);
+				pipe_frames++;
+			}
+
 			glfwPollEvents();
-			last_frame_time = now;
 			
 			framecnt++;
 			if ((now - last_framecnt_time) >= 1.0) {
 				std::cout << "[FPS] " << framecnt << std::endl;
+				std::cout << "[SIM] " << sim_hz << " Hz on simulation thread, " << sim_steps.exchange(0) << " steps, " << sim_dropped.exchange(0) << " dropped" << std::endl;
+				if (pipe_frames > 0)
+					std::cout << "[PIPE] input to present " << pipe_latency_ms / pipe_frames << " ms (max " << pipe_latency_max_ms << "), "
+						<< static_cast<double>(pipe_behind) / pipe_frames << " snapshots queued behind the rendered one, "
+						<< pipe_skipped << " skipped" << std::endl;
+				pipe_frames = pipe_skipped = pipe_behind = 0;
+				pipe_latency_ms = pipe_latency_max_ms = 0.0;
+				auto const pace = frame_limiter.stats();
+				std::cout << "[PACE] " << frame_limiter.mode_name();
+				if (frame_limiter.mode == FrameLimiter::Mode::limited)
+					std::cout << " at " << frame_limiter.target_fps << " fps";
+				std::cout << ", frame " << pace.mean_ms << " ms +- " << pace.stddev_ms << " (min " << pace.min_ms << ", max " << pace.max_ms
+					<< "), spin " << pace.spin_ms << " ms, sleep margin " << pace.margin_ms << " ms" << std::endl;
+				frame_limiter.reset_stats();
+				auto const& rq = render_queue.stats();
+				std::cout << "[DRAW] " << rq.draws << " draws (" << rq.opaque << " opaque, " << rq.blended << " blended), "
+					<< rq.program_changes << " program, " << rq.texture_changes << " texture, " << rq.vao_changes << " VAO changes"
+					<< (depth_prepass ? ", depth pre-pass" : "") << std::endl;
+				if (gpu_driven)
+					std::cout << "[GPU] " << indirect_renderer.instance_count() << " instances culled on GPU, "
+						<< indirect_renderer.group_count() << " multi-draw calls" << std::endl;
+				unsigned int queries = collision_queries.exchange(0), tests = collision_tests.exchange(0);
+				unsigned int contacts = collision_contacts.exchange(0);
+				std::cout << "[COLL] " << queries << " player moves, " << (queries ? static_cast<double>(tests) / queries : 0.0) << " boxes swept per move (of "
+					<< entities.size() << "), " << contacts
+					<< " wall contacts, grid " << collision_grid.columns() << 'x' << collision_grid.rows_count() << " with "
+					<< collision_grid.item_count() << " items, " << collision_grid.global_count() << " in every query" << std::endl;
+				std::cout << "[BROAD] " << moving_slots.size() << " moving in tree of height " << broad_height << ", "
+					<< broad_reinserts.exchange(0) << " reinserts, " << broad_pairs.exchange(0) << " moving pairs, "
+					<< broad_static_contacts.exchange(0) << " static contacts" << std::endl;
+				std::uint32_t seen = looked_at;
+				std::cout << "[RAY] ";
+				if (seen == GridRaycaster::none)
+					std::cout << "looking at nothing";
+				else
+					std::cout << "looking at entity " << seen << " at " << looked_at_distance << " m";
+				std::cout << ", " << looked_at_cells << " cells walked, grid " << maze_raycaster.dimensions().x << 'x' << maze_raycaster.dimensions().y
+					<< 'x' << maze_raycaster.dimensions().z << std::endl;
+				std::cout << "[XFORM] " << transforms.stats().updated << " of " << transforms.stats().nodes << " world matrices updated last frame" << std::endl;
+				std::cout << "[GEOM] " << (GeometryPool::get().vertex_bytes() + GeometryPool::get().index_bytes()) / 1024 << " KiB in shared geometry pool" << std::endl;
+				std::cout << "[RES] " << (dynamic_resolution.enabled ? "dynamic" : "fixed") << " scale " << dynamic_resolution.scale()
+					<< " (" << dynamic_resolution.render_width() << 'x' << dynamic_resolution.render_height() << "), GPU "
+					<< dynamic_resolution.gpu_ms() << " ms, target " << dynamic_resolution.target_ms << " ms" << std::endl;
+				std::cout << "[SHADOW] static map rendered " << sun_shadows.static_renders() << "x, "
+					<< sun_shadows.dynamic_casters() << " casters in dynamic map" << std::endl;
+				std::cout << "[LIGHT] " << lights.light_count() << " lights, " << lights.stats().visible_lights << " in view, "
+					<< lights.stats().light_indices << " cluster entries (max " << lights.stats().max_per_cluster << " per cluster), "
+					<< lights.stats().build_ms << " ms to build" << std::endl;
+				std::cout << "[STREAM] " << frame_stream.lastFrame().bytes / 1024 << " KiB/frame"
+					<< (frame_stream.persistent() ? " persistent mapped" : " glBufferSubData fallback") << ", "
+					<< frame_stream.lastFrame().waits << " fence waits, " << frame_stream.lastFrame().wait_ms << " ms stalled" << std::endl;
+				std::cout << "[GL] " << GLState::lastFrame().issued << " state calls issued, " << GLState::lastFrame().skipped << " skipped" << std::endl;
+				std::cout << "[TEX] " << texture_manager.texture_count() << " textures, "
+					<< texture_manager.bytes_used() / (1024 * 1024) << '/' << texture_manager.budget() / (1024 * 1024) << " MiB, "
+					<< texture_array.layer_count() << " array layers (" << texture_array.byte_cost() / (1024 * 1024) << " MiB), "
+					<< texture_manager.dropped_levels() << " mip levels dropped" << std::endl;
 				last_framecnt_time = now;
 				framecnt = 0;
 			}
 		}
-
-		thread_should_end = true;
-		tracker_thread.join();
 	}
 	catch (std::exception const& e) {
 		std::cerr << "App failed : " << e.what() << std::endl;
@@ -652,6 +1066,18 @@ App::~App()
 		capture.release();
 
 	cv::destroyAllWindows();
+
+	// clean-up GL resources while context still exists
+	texture_manager.clear();
+	texture_array.clear();
+	lightmap.clear();
+	sun_shadows.clear();
+	dynamic_resolution.clear();
+	indirect_renderer.clear();
+	object_buffer.clear();
+	depth_shader.clear();
+	frame_stream.clear();
+	GeometryPool::get().clear();
 	
 	// clean-up GLFW
 	glfwTerminate();
@@ -677,6 +1103,7 @@ void App::tracker_thread_code(void)
 			cv::Point2f center_normalized = find_center_normalized_hsv(frame);
 
 			fronta.push_back(center_normalized);
+			glfwPostEmptyEvent(); // wake the main thread when it waits for events
 
 			if (thread_should_end)
 			{
@@ -1,7 +1,8 @@
 #pragma once
 
 #include <atomic>
-#include <unordered_map>
+#include <exception>
+#include <mutex>
 
 #include <opencv2\opencv.hpp>
 #include <GL/glew.h>
@@ -12,15 +13,30 @@
 #include "camera.h"
 #include "ShaderProgram.h"
 #include "Mesh.h"
+#include "TextureCache.h"
+#include "TextureManager.h"
+#include "TextureArray.h"
+#include "RenderQueue.h"
+#include "IndirectRenderer.h"
+#include "ObjectBuffer.h"
+#include "StreamBuffer.h"
+#include "ClusteredLights.h"
+#include "Lightmap.h"
+#include "SunShadows.h"
+#include "DynamicResolution.h"
+#include "FrameLimiter.h"
+#include "FrameSnapshot.h"
+#include "TripleBuffer.h"
+#include "EntityStore.h"
+#include "TransformSystem.h"
+#include "UniformGrid.h"
+#include "DynamicAabbTree.h"
+#include "CharacterController.h"
+#include "GridRaycaster.h"
+#include "MazeGenerator.h"
 #include "stb_image.h"
 
 
-struct GameObject {
-    glm::vec3 position = glm::vec3(0.);
-    glm::vec3 dimensions = glm::vec3(1.0);
-    Mesh mesh;
-};
-
 // our application class 
 class App {
 public:
@@ -34,8 +50,14 @@ public:
     cv::Point2f find_center_normalized_hsv(cv::Mat& frame);
 
     ~App(); //default destructor, called on app instance destruction
+
+    std::uint32_t maze_seed = 0; // 0 = random; same seed, same maze and lightmap cache
+    int maze_cells = 5; // per side, the block map is 2 * cells + 1 blocks wide
+    MazeGenerator::Algorithm maze_algorithm = MazeGenerator::Algorithm::backtracker;
+    double sim_hz = 60.0; // fixed simulation rate, independent of frame rate
 private:
     void tracker_thread_code(void);
+    void simulation_thread_code(void);
 
     void init_opencv();
     void init_glew(void);
@@ -44,6 +66,7 @@ private:
     void init_assets(void);
 
     GLuint loadTexture(char const* path);
+    void setTexture(Mesh& mesh, char const* path);
     GLuint gen_tex(const std::filesystem::path& file_name);
 
     void print_opencv_info();
@@ -67,9 +90,9 @@ private:
     uchar getmap(cv::Mat& map, int x, int y);
     void genLabyrinth(cv::Mat& map);
 
-    bool checkCollision(const GameObject& obj1, const GameObject& obj2);
+    bool checkCollision(const glm::vec3& position1, const glm::vec3& dimensions1, const glm::vec3& position2, const glm::vec3& dimensions2);
 
-    cv::Mat mapa = cv::Mat(11, 11, CV_8U); // unsigned char
+    cv::Mat mapa = cv::Mat(11, 11, CV_8U); // unsigned char, '#' wall, '.' floor, 'e' end; resized by genLabyrinth
 
     cv::VideoCapture capture;
     synced_deque<cv::Point2f> fronta;
@@ -90,16 +113,77 @@ private:
     float lastX = 0, lastY = 0, xoffset = 0, yoffset = 0;
     Camera camera = Camera(glm::vec3(0.0f, 5.0f, 10.0f));
 
+    // Textures
+    TextureCache texture_cache;
+    TextureManager texture_manager{ texture_cache, 256 * 1024 * 1024 }; // VRAM budget
+    TextureImportSettings texture_import_settings;
+    TextureArray texture_array{ texture_cache, 1024 }; // layer size
+    bool use_texture_array = true; // pack opaque textures into texture_array
+
     // Fullscreen/windowed
     bool isFullscreen = false;
     // Game Objects
-    std::unordered_map<std::string, GameObject> scene;
-    GameObject playerObject;
+    // simulated entities: transform and motion owned by the simulation thread, the renderer sets model matrices from snapshots
+    EntityStore entities;
+    Entity bunny_entity; // turns the moving objects around at its end positions
+    TransformSystem transforms; // render thread, model matrices of entities and attachments
+    TransformSystem::Node camera_node = TransformSystem::none;
+    TransformSystem::Node flashlight_node = TransformSystem::none;
+    glm::vec3 player_dimensions = glm::vec3(0.5f); // bounding box around the camera
+    CharacterController player_controller;
+    std::vector<Aabb> collision_candidates; // simulation thread, boxes around the player's move
+    UniformGrid collision_grid; // static entities by maze cell
+    std::vector<std::uint32_t> moving_slots; // simulated entities, not in the grid
+    DynamicAabbTree moving_tree; // simulation thread, moving entities; user = slot
+    std::vector<std::int32_t> moving_proxies; // tree proxy of moving_slots[i]
+    std::atomic<unsigned int> collision_queries = 0, collision_tests = 0; // since last report
+    std::atomic<unsigned int> collision_contacts = 0;
+    GridRaycaster maze_raycaster; // static entities, read only after init_assets
+    std::atomic<std::uint32_t> looked_at = GridRaycaster::none; // slot under the view ray, simulation thread
+    std::atomic<float> looked_at_distance = 0.0f;
+    std::atomic<unsigned int> looked_at_cells = 0;
+    std::atomic<unsigned int> broad_reinserts = 0, broad_pairs = 0, broad_static_contacts = 0; // since last report
+    std::atomic<int> broad_height = 0;
+    RenderQueue render_queue;
+    IndirectRenderer indirect_renderer;
+    ObjectBuffer object_buffer;
+    StreamBuffer frame_stream; // per-frame data, triple-buffered
+    ClusteredLights lights;
+    Lightmap lightmap; // static lighting of walls and floor
+    SunShadows sun_shadows;
+    DynamicResolution dynamic_resolution;
+    FrameLimiter frame_limiter;
+    bool redraw_requested = true; // on-demand pacing: input or state changed since last frame
+    bool gpu_driven = false; // GPU culling + multi-draw-indirect for opaque objects
+    bool depth_prepass = false; // opaque depth first, color pass with GL_EQUAL
+    ShaderProgram depth_shader;
     // Tracker
     bool trackFlashlight = true;
 
+	// Fixed-timestep simulation on its own thread, rendered interpolated between the last two steps
+	void simulate_step(GLfloat dt, const SimInput& input, bool animate);
+	void publish_snapshot(const SimInput& input);
+	Camera sim_camera; // position is simulation state, orientation comes with the input
+	int max_sim_steps = 5; // per wake-up; a longer stall drops simulation time instead of spiraling
+	std::mutex sim_input_mutex;
+	SimInput sim_input;
+	TripleBuffer<FrameSnapshot> snapshots;
+	std::atomic<bool> sim_should_end = false;
+	std::atomic<bool> sim_failed = false; // sim_error is set, run() rethrows it
+	std::exception_ptr sim_error;
+	std::atomic<bool> sim_animate = true;
+	std::atomic<std::uint64_t> sim_published = 0; // sequence of the newest snapshot
+	std::atomic<std::uint64_t> sim_last_moved = 0; // newest snapshot in which something moved
+	std::atomic<unsigned int> sim_steps = 0, sim_dropped = 0; // since last report
+	double sim_time = 0.0;
+	// pipeline measurements since last report
+	unsigned int pipe_frames = 0, pipe_skipped = 0, pipe_behind = 0;
+	double pipe_latency_ms = 0.0, pipe_latency_max_ms = 0.0;
+
 	// Moving objects 
 	void process_object_movement(GLfloat deltaTime);
+	void update_broadphase(void);
+	GridRaycaster::Hit raycast(const GridRaycaster::Ray& ray); // static and moving entities, simulation thread
         // Speed
     float superSpeed = 5.0f;
         // End position
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "Benchmarks.h"
+#include "CollisionKernels.h"
+#include "DynamicAabbTree.h"
+#include "GridRaycaster.h"
+#include "MazeGenerator.h"
+
+using bench_clock = std::chrono::steady_clock;
+
+static double ms_since(bench_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+int bench_broadphase(int bodies, int frames)
+{
+	std::mt19937 rng(12345);
+	// density stays about the same for any count
+	float world = 4.0f * std::cbrt(static_cast<float>(bodies));
+	std::uniform_real_distribution<float> position(0.0f, world), size(0.25f, 1.5f), speed(-0.05f, 0.05f);
+
+	std::vector<Aabb> boxes(bodies);
+	std::vector<glm::vec3> velocity(bodies);
+	std::vector<std::int32_t> proxies(bodies);
+	DynamicAabbTree tree;
+
+	auto start = bench_clock::now();
+	for (int i = 0; i < bodies; ++i) {
+		boxes[i] = Aabb::from_center(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(size(rng)));
+		velocity[i] = glm::vec3(speed(rng), speed(rng), speed(rng));
+		proxies[i] = tree.insert(boxes[i], i);
+	}
+	double build_ms = ms_since(start);
+
+	double move_ms = 0.0, pairs_ms = 0.0, brute_ms = 0.0;
+	unsigned int reinserts = 0, checked_frames = 0, mismatches = 0;
+	std::size_t pair_total = 0;
+	std::vector<std::pair<std::uint32_t, std::uint32_t>> tree_pairs, brute_pairs;
+
+	for (int f = 0; f < frames; ++f) {
+		// bounce inside the world
+		start = bench_clock::now();
+		for (int i = 0; i < bodies; ++i) {
+			glm::vec3 c = boxes[i].center() + velocity[i];
+			for (int a = 0; a < 3; ++a)
+				if (c[a] < 0.0f || c[a] > world)
+					velocity[i][a] = -velocity[i][a];
+			boxes[i].min += velocity[i];
+			boxes[i].max += velocity[i];
+			reinserts += tree.move(proxies[i], boxes[i]) ? 1 : 0;
+		}
+		move_ms += ms_since(start);
+
+		// fat boxes give candidates, the exact test keeps real overlaps
+		start = bench_clock::now();
+		tree_pairs.clear();
+		tree.query_pairs([&](std::int32_t a, std::int32_t b) {
+			std::uint32_t ua = tree.user(a), ub = tree.user(b);
+			if (boxes[ua].overlaps(boxes[ub]))
+				tree_pairs.emplace_back(std::min(ua, ub), std::max(ua, ub));
+		});
+		pairs_ms += ms_since(start);
+		pair_total += tree_pairs.size();
+
+		// brute force reference on every 10th frame, it is quadratic
+		if (f % 10 != 0)
+			continue;
+		start = bench_clock::now();
+		brute_pairs.clear();
+		for (int i = 0; i < bodies; ++i)
+			for (int j = i + 1; j < bodies; ++j)
+				if (boxes[i].overlaps(boxes[j]))
+					brute_pairs.emplace_back(i, j);
+		brute_ms += ms_since(start);
+		checked_frames++;
+
+		std::sort(tree_pairs.begin(), tree_pairs.end());
+		if (tree_pairs != brute_pairs)
+			mismatches++;
+		tree.validate();
+	}
+
+	std::cout << "[BENCH] broadphase, " << bodies << " moving bodies, " << frames << " frames, tree height " << tree.height() << std::endl;
+	std::cout << "  build " << build_ms << " ms, move " << move_ms / frames << " ms/frame ("
+		<< static_cast<double>(reinserts) / frames << " reinserts), pairs " << pairs_ms / frames << " ms/frame ("
+		<< static_cast<double>(pair_total) / frames << " overlaps)" << std::endl;
+	if (checked_frames > 0)
+		std::cout << "  brute force " << brute_ms / checked_frames << " ms/frame, " << checked_frames << " frames compared, "
+			<< mismatches << " mismatches" << std::endl;
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int bench_collision_kernels(int boxes, int queries)
+{
+	std::mt19937 rng(12345);
+	float world = 4.0f * std::cbrt(static_cast<float>(boxes));
+	std::uniform_real_distribution<float> position(0.0f, world), size(0.25f, 1.5f), unit(-1.0f, 1.0f);
+
+	BoxSoA set;
+	set.reserve(boxes);
+	for (int i = 0; i < boxes; ++i)
+		set.push_back(Aabb::from_center(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(size(rng), size(rng), size(rng))));
+
+	std::vector<Aabb> query_boxes(queries);
+	std::vector<glm::vec3> ray_origins(queries), ray_directions(queries);
+	for (int q = 0; q < queries; ++q) {
+		query_boxes[q] = Aabb::from_center(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(size(rng)));
+		ray_origins[q] = glm::vec3(position(rng), position(rng), position(rng));
+		ray_directions[q] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(1e-3f));
+	}
+	// tile: a block of boxes against the whole set
+	BoxSoA tile;
+	int tile_rows = std::min(boxes, 256);
+	for (int i = 0; i < tile_rows; ++i)
+		tile.push_back(query_boxes[i % queries]);
+
+	const std::size_t words = CollisionKernels::mask_words(set.size());
+	const double box_tests = static_cast<double>(boxes) * queries;
+	std::cout << "[BENCH] collision kernels, " << boxes << " boxes, " << queries << " queries and rays, "
+		<< tile_rows << 'x' << boxes << " tile, best path " << CollisionKernels::path_name(CollisionKernels::best_path()) << std::endl;
+
+	// results are one row per query, reused, so memory stays linear in the box count
+	std::vector<std::uint32_t> overlap_mask(words), ray_mask(words), reference_mask(words), reference_tile;
+	std::vector<float> t(boxes), reference_t(boxes);
+	double scalar_ns[3] = { 0.0, 0.0, 0.0 };
+	unsigned int mismatches = 0;
+
+	for (CollisionKernels::Path path : { CollisionKernels::Path::scalar, CollisionKernels::Path::sse, CollisionKernels::Path::avx2 }) {
+		if (!CollisionKernels::available(path))
+			continue;
+
+		std::vector<std::uint32_t> tile_masks(words * tile_rows);
+		unsigned int overlap_hits = 0, ray_hits = 0, tile_hits = 0;
+
+		auto start = bench_clock::now();
+		for (int q = 0; q < queries; ++q)
+			overlap_hits += CollisionKernels::overlap(set, query_boxes[q], overlap_mask.data(), path);
+		double overlap_ns = ms_since(start) * 1e6 / box_tests;
+
+		start = bench_clock::now();
+		for (int q = 0; q < queries; ++q)
+			ray_hits += CollisionKernels::raycast(set, ray_origins[q], ray_directions[q], world, ray_mask.data(), t.data(), path);
+		double ray_ns = ms_since(start) * 1e6 / box_tests;
+
+		start = bench_clock::now();
+		tile_hits = CollisionKernels::overlap_tile(tile, set, tile_masks.data(), path);
+		double tile_ns = ms_since(start) * 1e6 / (static_cast<double>(tile_rows) * boxes);
+
+		if (path == CollisionKernels::Path::scalar) {
+			reference_tile = tile_masks;
+			scalar_ns[0] = overlap_ns;
+			scalar_ns[1] = ray_ns;
+			scalar_ns[2] = tile_ns;
+		}
+
+		// untimed: every query again on this path and on the scalar one, compared row by row
+		bool same = tile_masks == reference_tile;
+		for (int q = 0; q < queries && same && path != CollisionKernels::Path::scalar; ++q) {
+			CollisionKernels::overlap(set, query_boxes[q], overlap_mask.data(), path);
+			CollisionKernels::overlap(set, query_boxes[q], reference_mask.data(), CollisionKernels::Path::scalar);
+			same = overlap_mask == reference_mask;
+
+			// t is written for hit boxes only
+			std::fill(t.begin(), t.end(), 0.0f);
+			std::fill(reference_t.begin(), reference_t.end(), 0.0f);
+			CollisionKernels::raycast(set, ray_origins[q], ray_directions[q], world, ray_mask.data(), t.data(), path);
+			CollisionKernels::raycast(set, ray_origins[q], ray_directions[q], world, reference_mask.data(), reference_t.data(), CollisionKernels::Path::scalar);
+			same = same && ray_mask == reference_mask && t == reference_t;
+		}
+		mismatches += same ? 0 : 1;
+
+		std::cout << "  " << CollisionKernels::path_name(path) << ": overlap " << overlap_ns << " ns/box (x" << scalar_ns[0] / overlap_ns << ", "
+			<< overlap_hits << " hits), ray " << ray_ns << " ns/box (x" << scalar_ns[1] / ray_ns << ", " << ray_hits << " hits), tile "
+			<< tile_ns << " ns/pair (x" << scalar_ns[2] / tile_ns << ", " << tile_hits << " hits)" << (same ? "" : ", MISMATCH against scalar") << std::endl;
+	}
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int bench_raycast(int rays, int maze_size)
+{
+	std::mt19937 rng(12345);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// a quarter of the cells walled, a floor under all of them, like the scene built from mapa
+	std::vector<Aabb> boxes;
+	std::vector<std::uint32_t> ids;
+	for (int z = 0; z < maze_size; ++z)
+		for (int x = 0; x < maze_size; ++x)
+			if (unit(rng) < 0.25f)
+				boxes.push_back(Aabb::from_center(glm::vec3(x, 0.5f, z), glm::vec3(1.0f)));
+	boxes.push_back(Aabb{ glm::vec3(-0.5f, -0.01f, -0.5f), glm::vec3(maze_size - 0.5f, 0.0f, maze_size - 0.5f) });
+	for (std::uint32_t i = 0; i < boxes.size(); ++i)
+		ids.push_back(i);
+
+	auto start = bench_clock::now();
+	GridRaycaster grid;
+	grid.build(glm::vec2(-0.5f), maze_size, maze_size, 1.0f, boxes, ids);
+	double build_ms = ms_since(start);
+
+	// eye height rays in all directions, slightly up or down
+	std::vector<GridRaycaster::Ray> batch(rays);
+	for (auto& ray : batch) {
+		ray.origin = glm::vec3(unit(rng) * maze_size, 0.5f, unit(rng) * maze_size);
+		float angle = unit(rng) * 6.2831853f;
+		ray.direction = glm::normalize(glm::vec3(std::cos(angle), (unit(rng) - 0.5f) * 0.2f, std::sin(angle)));
+		ray.max_distance = 0.5f * maze_size;
+	}
+
+	start = bench_clock::now();
+	std::vector<GridRaycaster::Hit> serial(batch.size());
+	for (std::size_t r = 0; r < batch.size(); ++r)
+		serial[r] = grid.raycast(batch[r]);
+	double serial_ms = ms_since(start);
+
+	start = bench_clock::now();
+	std::vector<GridRaycaster::Hit> parallel;
+	grid.raycast(batch, parallel);
+	double parallel_ms = ms_since(start);
+
+	unsigned int mismatches = 0, hit_count = 0;
+	double cells = 0.0, tests = 0.0;
+	for (std::size_t r = 0; r < batch.size(); ++r) {
+		if (serial[r].id != parallel[r].id || serial[r].distance != parallel[r].distance)
+			mismatches++;
+		hit_count += serial[r].hit() ? 1 : 0;
+		cells += serial[r].cells;
+		tests += serial[r].tests;
+	}
+
+	// brute force over every box for the first rays, it is slow
+	std::size_t checked = std::min<std::size_t>(batch.size(), 2000);
+	start = bench_clock::now();
+	for (std::size_t r = 0; r < checked; ++r) {
+		float best = std::numeric_limits<float>::infinity();
+		std::uint32_t best_id = GridRaycaster::none;
+		for (std::uint32_t b = 0; b < boxes.size(); ++b) {
+			float distance;
+			glm::vec3 normal;
+			if (GridRaycaster::intersect(boxes[b], batch[r], distance, normal) && distance < best) {
+				best = distance;
+				best_id = b;
+			}
+		}
+		bool same = (best_id == GridRaycaster::none) ? !serial[r].hit() : (serial[r].hit() && serial[r].distance == best);
+		mismatches += same ? 0 : 1;
+	}
+	double brute_ms = ms_since(start);
+
+	std::cout << "[BENCH] raycast, " << rays << " rays over a " << maze_size << 'x' << maze_size << " maze, " << boxes.size()
+		<< " boxes, grid built in " << build_ms << " ms" << std::endl;
+	std::cout << "  serial " << serial_ms * 1e3 / rays << " us/ray, parallel " << parallel_ms * 1e3 / rays << " us/ray (x"
+		<< serial_ms / parallel_ms << "), " << hit_count << " hits, " << cells / rays << " cells and " << tests / rays << " boxes per ray" << std::endl;
+	std::cout << "  brute force " << brute_ms * 1e3 / checked << " us/ray, " << checked << " rays compared, " << mismatches << " mismatches" << std::endl;
+	return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int bench_maze(int size)
+{
+	using Algorithm = MazeGenerator::Algorithm;
+	unsigned int failures = 0;
+	std::cout << "[BENCH] maze generation, " << size << 'x' << size << " cells" << std::endl;
+
+	for (Algorithm algorithm : { Algorithm::backtracker, Algorithm::wilson, Algorithm::eller, Algorithm::sidewinder }) {
+		auto start = bench_clock::now();
+		Maze maze = MazeGenerator::generate(algorithm, size, size, 12345);
+		double generate_ms = ms_since(start);
+
+		// perfect: all cells connected by exactly cells - 1 passages
+		start = bench_clock::now();
+		bool perfect = maze.connected() && maze.passages() == maze.cell_count() - 1;
+		int longest = 0;
+		maze.farthest(0, longest);
+		double bfs_ms = ms_since(start);
+
+		// same seed, same maze; compared on a small one
+		Maze a = MazeGenerator::generate(algorithm, 64, 48, 7), b = MazeGenerator::generate(algorithm, 64, 48, 7);
+		bool repeatable = true;
+		for (int y = 0; y <= 2 * a.height() && repeatable; ++y)
+			for (int x = 0; x <= 2 * a.width(); ++x)
+				repeatable = repeatable && a.wall(x, y) == b.wall(x, y);
+
+		failures += (perfect && repeatable) ? 0 : 1;
+		std::cout << "  " << MazeGenerator::name(algorithm) << ": " << generate_ms << " ms, " << maze.cell_count() / generate_ms / 1000.0
+			<< " Mcells/s, " << maze.bytes() / 1024 << " KiB, " << (perfect ? "perfect" : "NOT PERFECT") << (repeatable ? "" : ", NOT REPEATABLE")
+			<< ", longest path from the corner " << longest << " cells (BFS " << bfs_ms << " ms)" << std::endl;
+	}
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Command line benchmarks, run without a window: ICP.exe --bench-<name> [count]
+
+// dynamic AABB tree against brute force, random moving bodies; returns EXIT_FAILURE on a mismatch
+int bench_broadphase(int bodies, int frames = 300);
+
+// scalar, SSE and AVX2 collision kernels on random boxes; returns EXIT_FAILURE if the masks differ
+int bench_collision_kernels(int boxes, int queries = 2000);
+
+// grid DDA raycasts over a random maze, one by one and in parallel, checked against brute force
+int bench_raycast(int rays, int maze_size = 256);
+
+// every maze algorithm at size x size: cells per second, memory, BFS solvability and determinism
+int bench_maze(int size);
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <limits>
+
+#include "CharacterController.h"
+
+bool CharacterController::sweep(const Aabb& moving, const glm::vec3& d, const Aabb& collider, float& toi, glm::vec3& normal)
+{
+	// ray from the center against the collider grown by the half size (Minkowski sum)
+	const glm::vec3 half = moving.size() * 0.5f;
+	const glm::vec3 origin = moving.center();
+	const glm::vec3 lo = collider.min - half;
+	const glm::vec3 hi = collider.max + half;
+
+	float t_enter = -std::numeric_limits<float>::infinity();
+	float t_exit = std::numeric_limits<float>::infinity();
+	int axis = -1;
+	for (int a = 0; a < 3; ++a) {
+		if (d[a] == 0.0f) {
+			// open intervals like Aabb::overlaps, sliding exactly along a face is no contact
+			if (origin[a] <= lo[a] || origin[a] >= hi[a])
+				return false;
+			continue;
+		}
+		float inv = 1.0f / d[a];
+		float t0 = (lo[a] - origin[a]) * inv;
+		float t1 = (hi[a] - origin[a]) * inv;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if (t0 > t_enter) {
+			t_enter = t0;
+			axis = a;
+		}
+		t_exit = std::min(t_exit, t1);
+	}
+
+	if (axis < 0 || t_enter >= t_exit || t_enter > 1.0f || t_exit <= 0.0f)
+		return false;
+
+	normal = glm::vec3(0.0f);
+	if (t_enter >= 0.0f) {
+		normal[axis] = (d[axis] > 0.0f) ? -1.0f : 1.0f;
+		toi = t_enter;
+		return true;
+	}
+
+	// already overlapping (a moving object ran into the box): blocked only when moving
+	// further in through the nearest face, so the box can always get out
+	float depth = std::numeric_limits<float>::infinity();
+	for (int a = 0; a < 3; ++a) {
+		if (origin[a] - lo[a] < depth) {
+			depth = origin[a] - lo[a];
+			normal = glm::vec3(0.0f);
+			normal[a] = -1.0f;
+		}
+		if (hi[a] - origin[a] < depth) {
+			depth = hi[a] - origin[a];
+			normal = glm::vec3(0.0f);
+			normal[a] = 1.0f;
+		}
+	}
+	if (glm::dot(d, normal) >= 0.0f)
+		return false;
+	toi = 0.0f;
+	return true;
+}
+
+Aabb CharacterController::swept_box(const glm::vec3& position, const glm::vec3& size, const glm::vec3& displacement) const
+{
+	Aabb start = Aabb::from_center(position, size);
+	Aabb end = Aabb::from_center(position + displacement, size);
+	return start.merged(end).expanded(skin);
+}
+
+CharacterController::Result CharacterController::move(const glm::vec3& position, const glm::vec3& size, const glm::vec3& displacement,
+	const std::vector<Aabb>& colliders) const
+{
+	Result r;
+	r.position = position;
+
+	if (displacement == glm::vec3(0.0f))
+		return r;
+
+	const glm::vec3 half = size * 0.5f;
+	glm::vec3 remaining = displacement;
+	for (int slide = 0; slide < max_slides; ++slide) {
+		// earliest hit of the remaining move
+		Aabb box = Aabb::from_center(r.position, size);
+		float toi = 1.0f;
+		glm::vec3 normal(0.0f);
+		int hit = -1;
+		for (std::size_t c = 0; c < colliders.size(); ++c) {
+			float t;
+			glm::vec3 n;
+			if (sweep(box, remaining, colliders[c], t, n) && t < toi) {
+				toi = t;
+				normal = n;
+				hit = static_cast<int>(c);
+			}
+		}
+
+		if (hit < 0) {
+			r.position += remaining;
+			break;
+		}
+
+		// advance to the contact and stand exactly skin off the face, float error cannot push inside;
+		// a box that already overlaps stays where it is
+		int axis = (normal.x != 0.0f) ? 0 : (normal.y != 0.0f) ? 1 : 2;
+		if (!box.overlaps(colliders[hit])) {
+			r.position += remaining * toi;
+			r.position[axis] = (normal[axis] > 0.0f) ? colliders[hit].max[axis] + half[axis] + skin
+				: colliders[hit].min[axis] - half[axis] - skin;
+		}
+		r.contacts++;
+		r.blocked = true;
+
+		// slide: keep the rest of the move without its part into the face
+		remaining *= 1.0f - toi;
+		remaining[axis] = 0.0f;
+		if (remaining == glm::vec3(0.0f))
+			break;
+	}
+	return r;
+}
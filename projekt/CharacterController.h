@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Aabb.h"
+
+// Swept AABB movement with sliding along the hit walls
+//
+// The player box is swept against the candidate boxes as a ray from its center
+// against the boxes grown by its half size, so the time of impact is exact for
+// any displacement and thin walls cannot be skipped. On a hit the box stops a small
+// skin away from the face, the part of the displacement into the face is dropped
+// and the rest slides along it, up to max_slides times. The colliders are a snapshot
+// for the whole move, so one sweep of the full displacement is enough.
+class CharacterController {
+public:
+	float skin = 0.001f;             // gap kept to the faces
+	int max_slides = 4;              // per move
+
+	struct Result {
+		glm::vec3 position = glm::vec3(0.0f);
+		unsigned int contacts = 0;   // faces hit, each one slid along
+		bool blocked = false;        // some displacement was removed
+	};
+
+	// moves a box of the given size centered at position; colliders should cover the whole swept box
+	Result move(const glm::vec3& position, const glm::vec3& size, const glm::vec3& displacement,
+		const std::vector<Aabb>& colliders) const;
+
+	// box covering every position of the move, for gathering colliders
+	Aabb swept_box(const glm::vec3& position, const glm::vec3& size, const glm::vec3& displacement) const;
+
+	// time of impact in [0, 1] of a box moving by d against a collider, with the hit face normal;
+	// false if it does not hit or already overlaps and moves out
+	static bool sweep(const Aabb& moving, const glm::vec3& d, const Aabb& collider, float& toi, glm::vec3& normal);
+};
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <execution>
+#include <numeric>
+
+#include "ClusteredLights.h"
+
+unsigned int ClusteredLights::slice(float depth) const
+{
+	// exponential slicing: equal ratio between slice far and near planes
+	float s = std::log(std::max(depth, cluster_near) / cluster_near) / std::log(cluster_far / cluster_near) * grid_z;
+	return std::min(static_cast<unsigned int>(std::max(s, 0.0f)), grid_z - 1);
+}
+
+void ClusteredLights::build_cluster_bounds(const glm::mat4& projection_matrix)
+{
+	bounds_projection = projection_matrix;
+	bounds.resize(cluster_count);
+
+	glm::mat4 inverse_projection = glm::inverse(projection_matrix);
+	auto ray = [&](float ndc_x, float ndc_y) {
+		// point on the near plane, scaled later to the wanted depth
+		glm::vec4 p = inverse_projection * glm::vec4(ndc_x, ndc_y, -1.0f, 1.0f);
+		glm::vec3 v = glm::vec3(p) / p.w;
+		return v / -v.z;
+	};
+
+	for (unsigned int z = 0; z < grid_z; ++z) {
+		float d0 = cluster_near * std::pow(cluster_far / cluster_near, static_cast<float>(z) / grid_z);
+		float d1 = cluster_near * std::pow(cluster_far / cluster_near, static_cast<float>(z + 1) / grid_z);
+		if (z == grid_z - 1)
+			d1 = cluster_far * 1000.0f; // last slice takes everything beyond
+
+		for (unsigned int y = 0; y < grid_y; ++y) {
+			for (unsigned int x = 0; x < grid_x; ++x) {
+				float x0 = -1.0f + 2.0f * x / grid_x, x1 = -1.0f + 2.0f * (x + 1) / grid_x;
+				float y0 = -1.0f + 2.0f * y / grid_y, y1 = -1.0f + 2.0f * (y + 1) / grid_y;
+				glm::vec3 corners[4] = { ray(x0, y0), ray(x1, y0), ray(x0, y1), ray(x1, y1) };
+
+				Aabb& b = bounds[(z * grid_y + y) * grid_x + x];
+				b.lo = glm::vec3(1e30f);
+				b.hi = glm::vec3(-1e30f);
+				for (const glm::vec3& c : corners) {
+					for (float d : { d0, d1 }) {
+						b.lo = glm::min(b.lo, c * d);
+						b.hi = glm::max(b.hi, c * d);
+					}
+				}
+			}
+		}
+	}
+}
+
+void ClusteredLights::build(const glm::mat4& projection_matrix, const glm::mat4& view_matrix, int width, int height)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	if (bounds.empty() || projection_matrix != bounds_projection)
+		build_cluster_bounds(projection_matrix);
+
+	float log_ratio = std::log(cluster_far / cluster_near);
+	header.grid = glm::uvec4(grid_x, grid_y, grid_z, 0);
+	header.params = glm::vec4(
+		static_cast<float>(std::max(width, 1)) / grid_x,
+		static_cast<float>(std::max(height, 1)) / grid_y,
+		grid_z / log_ratio,
+		-grid_z * std::log(cluster_near) / log_ratio);
+
+	// lights to view space, depth range of each sphere in slices
+	view_lights.resize(lights.size());
+	slice_range.resize(lights.size());
+	for (size_t i = 0; i < lights.size(); ++i) {
+		const PointLight& l = lights[i];
+		glm::vec3 p = glm::vec3(view_matrix * glm::vec4(l.position, 1.0f));
+		view_lights[i].position_radius = glm::vec4(p, l.radius);
+		view_lights[i].color_ambient = glm::vec4(l.color * l.intensity, l.ambient);
+		view_lights[i].baked = l.baked ? 1 : 0;
+
+		float depth = -p.z;
+		if (depth + l.radius < cluster_near)
+			slice_range[i] = glm::ivec2(1, 0); // behind the camera
+		else
+			slice_range[i] = glm::ivec2(slice(depth - l.radius), slice(depth + l.radius));
+	}
+
+	// slices are independent, each worker fills the clusters of its slices
+	cluster_lights.resize(static_cast<std::size_t>(cluster_count) * max_lights_per_cluster);
+	cluster_counts.assign(cluster_count, 0);
+
+	std::vector<unsigned int> slices(grid_z);
+	std::iota(slices.begin(), slices.end(), 0);
+	std::for_each(std::execution::par, slices.begin(), slices.end(), [&](unsigned int z) {
+		for (size_t i = 0; i < view_lights.size(); ++i) {
+			if (static_cast<int>(z) < slice_range[i].x || static_cast<int>(z) > slice_range[i].y)
+				continue;
+
+			glm::vec3 center = glm::vec3(view_lights[i].position_radius);
+			float radius = view_lights[i].position_radius.w;
+			for (unsigned int c = z * grid_x * grid_y; c < (z + 1) * grid_x * grid_y; ++c) {
+				// sphere vs AABB
+				glm::vec3 closest = glm::clamp(center, bounds[c].lo, bounds[c].hi);
+				glm::vec3 delta = closest - center;
+				if (glm::dot(delta, delta) > radius * radius)
+					continue;
+
+				GLuint& count = cluster_counts[c];
+				if (count < max_lights_per_cluster)
+					cluster_lights[static_cast<std::size_t>(c) * max_lights_per_cluster + count++] = static_cast<GLuint>(i);
+			}
+		}
+	});
+
+	// stats
+	last = Stats();
+	std::vector<bool> visible(lights.size(), false);
+	for (unsigned int c = 0; c < cluster_count; ++c) {
+		last.light_indices += cluster_counts[c];
+		last.max_per_cluster = std::max(last.max_per_cluster, cluster_counts[c]);
+		for (GLuint k = 0; k < cluster_counts[c]; ++k)
+			visible[cluster_lights[static_cast<std::size_t>(c) * max_lights_per_cluster + k]] = true;
+	}
+	last.visible_lights = static_cast<unsigned int>(std::count(visible.begin(), visible.end(), true));
+	last.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::size_t ClusteredLights::bytes_per_frame(void) const
+{
+	// bindings must not be empty, hence the max()
+	return std::max<std::size_t>(view_lights.size(), 1) * sizeof(GpuLight)
+		+ sizeof(ClusterHeader) + cluster_count * sizeof(glm::uvec2)
+		+ std::max<std::size_t>(last.light_indices, 1) * sizeof(GLuint)
+		+ 3 * 256; // padding of each allocation, offset alignment is at most 256 by the GL spec
+}
+
+void ClusteredLights::upload(StreamBuffer& stream)
+{
+	StreamBuffer::Allocation light_alloc = stream.allocate(std::max<std::size_t>(view_lights.size(), 1) * sizeof(GpuLight));
+	std::copy(view_lights.begin(), view_lights.end(), static_cast<GpuLight*>(light_alloc.data));
+
+	// header followed by (offset, count) per cluster
+	StreamBuffer::Allocation cluster_alloc = stream.allocate(sizeof(ClusterHeader) + cluster_count * sizeof(glm::uvec2));
+	StreamBuffer::Allocation index_alloc = stream.allocate(std::max<std::size_t>(last.light_indices, 1) * sizeof(GLuint));
+
+	*static_cast<ClusterHeader*>(cluster_alloc.data) = header;
+	glm::uvec2* clusters = reinterpret_cast<glm::uvec2*>(static_cast<unsigned char*>(cluster_alloc.data) + sizeof(ClusterHeader));
+	GLuint* indices = static_cast<GLuint*>(index_alloc.data);
+
+	GLuint offset = 0;
+	for (unsigned int c = 0; c < cluster_count; ++c) {
+		clusters[c] = glm::uvec2(offset, cluster_counts[c]);
+		const GLuint* src = &cluster_lights[static_cast<std::size_t>(c) * max_lights_per_cluster];
+		std::copy(src, src + cluster_counts[c], indices + offset);
+		offset += cluster_counts[c];
+	}
+
+	stream.commit(light_alloc);
+	stream.commit(cluster_alloc);
+	stream.commit(index_alloc);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, light_binding, stream.id(), light_alloc.offset, light_alloc.size);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, cluster_binding, stream.id(), cluster_alloc.offset, cluster_alloc.size);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index_binding, stream.id(), index_alloc.offset, index_alloc.size);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Lights.h"
+#include "StreamBuffer.h"
+
+// Clustered forward lighting
+//
+// The view frustum is split into grid_x * grid_y screen tiles times grid_z
+// exponential depth slices. Each frame the lights are assigned on the CPU to every
+// cluster their sphere touches (slices processed in parallel) and the light list,
+// per-cluster (offset, count) table and light index list are written into the
+// frame StreamBuffer. obj.frag finds its cluster from gl_FragCoord and view depth
+// and loops over that cluster's lights only.
+class ClusteredLights {
+public:
+	static constexpr GLuint light_binding = 3;
+	static constexpr GLuint cluster_binding = 4;
+	static constexpr GLuint index_binding = 5;
+
+	static constexpr unsigned int grid_x = 16;
+	static constexpr unsigned int grid_y = 9;
+	static constexpr unsigned int grid_z = 24;
+	static constexpr unsigned int cluster_count = grid_x * grid_y * grid_z;
+	static constexpr unsigned int max_lights_per_cluster = 64; // further lights are dropped
+
+	struct Stats {
+		unsigned int visible_lights = 0;    // assigned to at least one cluster
+		unsigned int light_indices = 0;     // sum over clusters
+		unsigned int max_per_cluster = 0;
+		double build_ms = 0.0;
+	};
+
+	std::size_t add(const PointLight& light) { lights.push_back(light); return lights.size() - 1; }
+	PointLight& light(std::size_t i) { return lights[i]; }
+	std::size_t light_count(void) const { return lights.size(); }
+
+	// depth range covered by slices, farther fragments use the last slice
+	float cluster_near = 0.1f;
+	float cluster_far = 100.0f;
+
+	// assign lights to clusters for this view and viewport size
+	void build(const glm::mat4& projection_matrix, const glm::mat4& view_matrix, int width, int height);
+	// stream space needed by upload() for the last build()
+	std::size_t bytes_per_frame(void) const;
+	// write into stream and bind the three SSBOs
+	void upload(StreamBuffer& stream);
+
+	const Stats& stats(void) const { return last; }
+
+private:
+	// std430 layouts, must match obj.frag
+	struct GpuLight {
+		glm::vec4 position_radius;  // view space
+		glm::vec4 color_ambient;
+		GLuint baked;
+		GLuint pad[3];
+	};
+	struct ClusterHeader {
+		glm::uvec4 grid;
+		glm::vec4 params;           // tile width, tile height (pixels), slice scale, slice bias
+	};
+
+	struct Aabb {
+		glm::vec3 lo;
+		glm::vec3 hi;
+	};
+
+	void build_cluster_bounds(const glm::mat4& projection_matrix);
+	unsigned int slice(float depth) const;
+
+	std::vector<PointLight> lights;
+
+	// view space cluster bounds, only depend on the projection
+	std::vector<Aabb> bounds;
+	glm::mat4 bounds_projection = glm::mat4(0.0f);
+
+	ClusterHeader header{};
+	std::vector<GpuLight> view_lights;
+	std::vector<glm::ivec2> slice_range;           // per light, first and last slice, x > y = not visible
+	std::vector<GLuint> cluster_lights;            // cluster_count * max_lights_per_cluster
+	std::vector<GLuint> cluster_counts;
+
+	Stats last;
+};
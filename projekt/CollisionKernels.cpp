@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstring>
+
+#include "CollisionKernels.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define KERNELS_AVX2 // MSVC compiles AVX2 intrinsics without /arch
+#else
+#define KERNELS_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+void BoxSoA::clear(void)
+{
+	cx.clear(); cy.clear(); cz.clear();
+	hx.clear(); hy.clear(); hz.clear();
+}
+
+void BoxSoA::reserve(std::size_t n)
+{
+	cx.reserve(n); cy.reserve(n); cz.reserve(n);
+	hx.reserve(n); hy.reserve(n); hz.reserve(n);
+}
+
+void BoxSoA::push_back(const Aabb& box)
+{
+	glm::vec3 c = box.center(), h = box.size() * 0.5f;
+	cx.push_back(c.x); cy.push_back(c.y); cz.push_back(c.z);
+	hx.push_back(h.x); hy.push_back(h.y); hz.push_back(h.z);
+}
+
+bool CollisionKernels::available(Path path)
+{
+#ifdef KERNELS_X86
+	if (path == Path::avx2) {
+		static const bool avx2 = [] {
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+			bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+			__cpuidex(info, 7, 0);
+			return os_avx && (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") != 0;
+#endif
+		}();
+		return avx2;
+	}
+	return true;
+#else
+	return path == Path::scalar;
+#endif
+}
+
+CollisionKernels::Path CollisionKernels::best_path(void)
+{
+	static const Path best = available(Path::avx2) ? Path::avx2 : available(Path::sse) ? Path::sse : Path::scalar;
+	return best;
+}
+
+const char* CollisionKernels::path_name(Path path)
+{
+	switch (path) {
+	case Path::sse: return "SSE";
+	case Path::avx2: return "AVX2";
+	default: return "scalar";
+	}
+}
+
+// ---- scalar, also the tail of the SIMD versions
+
+static unsigned int overlap_scalar(const BoxSoA& b, std::size_t first, std::size_t last, const glm::vec3& qc, const glm::vec3& qh, std::uint32_t* mask)
+{
+	unsigned int hits = 0;
+	for (std::size_t i = first; i < last; ++i) {
+		bool hit = std::fabs(b.cx[i] - qc.x) < b.hx[i] + qh.x &&
+			std::fabs(b.cy[i] - qc.y) < b.hy[i] + qh.y &&
+			std::fabs(b.cz[i] - qc.z) < b.hz[i] + qh.z;
+		if (hit) {
+			mask[i >> 5] |= 1u << (i & 31);
+			++hits;
+		}
+	}
+	return hits;
+}
+
+static unsigned int raycast_scalar(const BoxSoA& b, std::size_t first, std::size_t last, const glm::vec3& o, const glm::vec3& inv, float t_max,
+	std::uint32_t* mask, float* t)
+{
+	unsigned int hits = 0;
+	for (std::size_t i = first; i < last; ++i) {
+		float x0 = (b.cx[i] - b.hx[i] - o.x) * inv.x, x1 = (b.cx[i] + b.hx[i] - o.x) * inv.x;
+		float y0 = (b.cy[i] - b.hy[i] - o.y) * inv.y, y1 = (b.cy[i] + b.hy[i] - o.y) * inv.y;
+		float z0 = (b.cz[i] - b.hz[i] - o.z) * inv.z, z1 = (b.cz[i] + b.hz[i] - o.z) * inv.z;
+		float t_near = std::max(std::max(std::min(x0, x1), std::min(y0, y1)), std::min(z0, z1));
+		float t_far = std::min(std::min(std::max(x0, x1), std::max(y0, y1)), std::max(z0, z1));
+		if (t_near <= t_far && t_far > 0.0f && t_near < t_max) {
+			mask[i >> 5] |= 1u << (i & 31);
+			if (t)
+				t[i] = std::max(t_near, 0.0f);
+			++hits;
+		}
+	}
+	return hits;
+}
+
+#ifdef KERNELS_X86
+
+// ---- SSE, 4 boxes per batch
+
+static unsigned int overlap_sse(const BoxSoA& b, std::size_t n, const glm::vec3& qc, const glm::vec3& qh, std::uint32_t* mask)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 qcx = _mm_set1_ps(qc.x), qcy = _mm_set1_ps(qc.y), qcz = _mm_set1_ps(qc.z);
+	const __m128 qhx = _mm_set1_ps(qh.x), qhy = _mm_set1_ps(qh.y), qhz = _mm_set1_ps(qh.z);
+	unsigned int hits = 0;
+	for (std::size_t i = 0; i < n; i += 4) {
+		__m128 dx = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(&b.cx[i]), qcx));
+		__m128 dy = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(&b.cy[i]), qcy));
+		__m128 dz = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(&b.cz[i]), qcz));
+		__m128 hit = _mm_and_ps(_mm_cmplt_ps(dx, _mm_add_ps(_mm_loadu_ps(&b.hx[i]), qhx)),
+			_mm_and_ps(_mm_cmplt_ps(dy, _mm_add_ps(_mm_loadu_ps(&b.hy[i]), qhy)),
+				_mm_cmplt_ps(dz, _mm_add_ps(_mm_loadu_ps(&b.hz[i]), qhz))));
+		unsigned int bits = static_cast<unsigned int>(_mm_movemask_ps(hit));
+		mask[i >> 5] |= bits << (i & 31);
+		hits += static_cast<unsigned int>(std::bitset<4>(bits).count());
+	}
+	return hits;
+}
+
+static unsigned int raycast_sse(const BoxSoA& b, std::size_t n, const glm::vec3& o, const glm::vec3& inv, float t_max, std::uint32_t* mask, float* t)
+{
+	const __m128 ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y), oz = _mm_set1_ps(o.z);
+	const __m128 ix = _mm_set1_ps(inv.x), iy = _mm_set1_ps(inv.y), iz = _mm_set1_ps(inv.z);
+	const __m128 zero = _mm_setzero_ps(), tm = _mm_set1_ps(t_max);
+	unsigned int hits = 0;
+	for (std::size_t i = 0; i < n; i += 4) {
+		__m128 cx = _mm_loadu_ps(&b.cx[i]), hx = _mm_loadu_ps(&b.hx[i]);
+		__m128 cy = _mm_loadu_ps(&b.cy[i]), hy = _mm_loadu_ps(&b.hy[i]);
+		__m128 cz = _mm_loadu_ps(&b.cz[i]), hz = _mm_loadu_ps(&b.hz[i]);
+		__m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(cx, hx), ox), ix), x1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(cx, hx), ox), ix);
+		__m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(cy, hy), oy), iy), y1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(cy, hy), oy), iy);
+		__m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(cz, hz), oz), iz), z1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(cz, hz), oz), iz);
+		__m128 t_near = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_min_ps(z0, z1));
+		__m128 t_far = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_max_ps(z0, z1));
+		__m128 hit = _mm_and_ps(_mm_cmple_ps(t_near, t_far), _mm_and_ps(_mm_cmpgt_ps(t_far, zero), _mm_cmplt_ps(t_near, tm)));
+		unsigned int bits = static_cast<unsigned int>(_mm_movemask_ps(hit));
+		if (bits == 0)
+			continue;
+		mask[i >> 5] |= bits << (i & 31);
+		hits += static_cast<unsigned int>(std::bitset<4>(bits).count());
+		if (t) {
+			alignas(16) float near_t[4];
+			_mm_store_ps(near_t, _mm_max_ps(t_near, zero));
+			for (unsigned int k = 0; k < 4; ++k)
+				if (bits & (1u << k))
+					t[i + k] = near_t[k];
+		}
+	}
+	return hits;
+}
+
+// ---- AVX2, 8 boxes per batch
+
+KERNELS_AVX2 static unsigned int overlap_avx2(const BoxSoA& b, std::size_t n, const glm::vec3& qc, const glm::vec3& qh, std::uint32_t* mask)
+{
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	const __m256 qcx = _mm256_set1_ps(qc.x), qcy = _mm256_set1_ps(qc.y), qcz = _mm256_set1_ps(qc.z);
+	const __m256 qhx = _mm256_set1_ps(qh.x), qhy = _mm256_set1_ps(qh.y), qhz = _mm256_set1_ps(qh.z);
+	unsigned int hits = 0;
+	for (std::size_t i = 0; i < n; i += 8) {
+		__m256 dx = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&b.cx[i]), qcx));
+		__m256 dy = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&b.cy[i]), qcy));
+		__m256 dz = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(&b.cz[i]), qcz));
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(dx, _mm256_add_ps(_mm256_loadu_ps(&b.hx[i]), qhx), _CMP_LT_OQ),
+			_mm256_and_ps(_mm256_cmp_ps(dy, _mm256_add_ps(_mm256_loadu_ps(&b.hy[i]), qhy), _CMP_LT_OQ),
+				_mm256_cmp_ps(dz, _mm256_add_ps(_mm256_loadu_ps(&b.hz[i]), qhz), _CMP_LT_OQ)));
+		unsigned int bits = static_cast<unsigned int>(_mm256_movemask_ps(hit));
+		mask[i >> 5] |= bits << (i & 31);
+		hits += static_cast<unsigned int>(std::bitset<8>(bits).count());
+	}
+	return hits;
+}
+
+KERNELS_AVX2 static unsigned int raycast_avx2(const BoxSoA& b, std::size_t n, const glm::vec3& o, const glm::vec3& inv, float t_max, std::uint32_t* mask, float* t)
+{
+	const __m256 ox = _mm256_set1_ps(o.x), oy = _mm256_set1_ps(o.y), oz = _mm256_set1_ps(o.z);
+	const __m256 ix = _mm256_set1_ps(inv.x), iy = _mm256_set1_ps(inv.y), iz = _mm256_set1_ps(inv.z);
+	const __m256 zero = _mm256_setzero_ps(), tm = _mm256_set1_ps(t_max);
+	unsigned int hits = 0;
+	for (std::size_t i = 0; i < n; i += 8) {
+		__m256 cx = _mm256_loadu_ps(&b.cx[i]), hx = _mm256_loadu_ps(&b.hx[i]);
+		__m256 cy = _mm256_loadu_ps(&b.cy[i]), hy = _mm256_loadu_ps(&b.hy[i]);
+		__m256 cz = _mm256_loadu_ps(&b.cz[i]), hz = _mm256_loadu_ps(&b.hz[i]);
+		__m256 x0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(cx, hx), ox), ix), x1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(cx, hx), ox), ix);
+		__m256 y0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(cy, hy), oy), iy), y1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(cy, hy), oy), iy);
+		__m256 z0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(cz, hz), oz), iz), z1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_add_ps(cz, hz), oz), iz);
+		__m256 t_near = _mm256_max_ps(_mm256_max_ps(_mm256_min_ps(x0, x1), _mm256_min_ps(y0, y1)), _mm256_min_ps(z0, z1));
+		__m256 t_far = _mm256_min_ps(_mm256_min_ps(_mm256_max_ps(x0, x1), _mm256_max_ps(y0, y1)), _mm256_max_ps(z0, z1));
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(t_near, t_far, _CMP_LE_OQ),
+			_mm256_and_ps(_mm256_cmp_ps(t_far, zero, _CMP_GT_OQ), _mm256_cmp_ps(t_near, tm, _CMP_LT_OQ)));
+		unsigned int bits = static_cast<unsigned int>(_mm256_movemask_ps(hit));
+		if (bits == 0)
+			continue;
+		mask[i >> 5] |= bits << (i & 31);
+		hits += static_cast<unsigned int>(std::bitset<8>(bits).count());
+		if (t) {
+			alignas(32) float near_t[8];
+			_mm256_store_ps(near_t, _mm256_max_ps(t_near, zero));
+			for (unsigned int k = 0; k < 8; ++k)
+				if (bits & (1u << k))
+					t[i + k] = near_t[k];
+		}
+	}
+	return hits;
+}
+
+#endif
+
+// ---- dispatch
+
+static unsigned int overlap_any(const BoxSoA& boxes, const glm::vec3& qc, const glm::vec3& qh, std::uint32_t* mask, CollisionKernels::Path path)
+{
+	using Path = CollisionKernels::Path;
+	const std::size_t n = boxes.size();
+	std::memset(mask, 0, CollisionKernels::mask_words(n) * sizeof(std::uint32_t));
+
+	std::size_t done = 0;
+	unsigned int hits = 0;
+#ifdef KERNELS_X86
+	if (path == Path::avx2 && CollisionKernels::available(Path::avx2)) {
+		done = n & ~std::size_t(7);
+		hits = overlap_avx2(boxes, done, qc, qh, mask);
+	}
+	else if (path != Path::scalar) {
+		done = n & ~std::size_t(3);
+		hits = overlap_sse(boxes, done, qc, qh, mask);
+	}
+#endif
+	return hits + overlap_scalar(boxes, done, n, qc, qh, mask);
+}
+
+unsigned int CollisionKernels::overlap(const BoxSoA& boxes, const Aabb& query, std::uint32_t* mask, Path path)
+{
+	return overlap_any(boxes, query.center(), query.size() * 0.5f, mask, path);
+}
+
+unsigned int CollisionKernels::raycast(const BoxSoA& boxes, const glm::vec3& origin, const glm::vec3& direction, float t_max,
+	std::uint32_t* mask, float* t, Path path)
+{
+	const std::size_t n = boxes.size();
+	std::memset(mask, 0, mask_words(n) * sizeof(std::uint32_t));
+	const glm::vec3 inv = 1.0f / direction;
+
+	std::size_t done = 0;
+	unsigned int hits = 0;
+#ifdef KERNELS_X86
+	if (path == Path::avx2 && available(Path::avx2)) {
+		done = n & ~std::size_t(7);
+		hits = raycast_avx2(boxes, done, origin, inv, t_max, mask, t);
+	}
+	else if (path != Path::scalar) {
+		done = n & ~std::size_t(3);
+		hits = raycast_sse(boxes, done, origin, inv, t_max, mask, t);
+	}
+#endif
+	return hits + raycast_scalar(boxes, done, n, origin, inv, t_max, mask, t);
+}
+
+unsigned int CollisionKernels::overlap_tile(const BoxSoA& a, const BoxSoA& b, std::uint32_t* masks, Path path)
+{
+	// one row per box of a; b stays in cache while the rows go over it
+	const std::size_t words = mask_words(b.size());
+	unsigned int hits = 0;
+	for (std::size_t i = 0; i < a.size(); ++i)
+		hits += overlap_any(b, glm::vec3(a.cx[i], a.cy[i], a.cz[i]), glm::vec3(a.hx[i], a.hy[i], a.hz[i]), masks + i * words, path);
+	return hits;
+}
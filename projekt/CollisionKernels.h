@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Aabb.h"
+
+// Boxes as separate arrays of centers and half extents, the layout the kernels load 4 or 8 at a time
+struct BoxSoA {
+	std::vector<float> cx, cy, cz;
+	std::vector<float> hx, hy, hz;
+
+	void clear(void);
+	void reserve(std::size_t n);
+	void push_back(const Aabb& box);
+	std::size_t size(void) const { return cx.size(); }
+};
+
+// Batched box overlap and ray-box tests over a BoxSoA
+//
+// Results are hit masks, bit i of word i / 32 set when box i is hit, plus the
+// number of hits. Each test has a scalar version and SSE (4 boxes) and AVX2
+// (8 boxes) versions; the best one the CPU supports is picked at run time and
+// the rest of the boxes after the last full batch go through the scalar code.
+// Overlaps use open intervals like Aabb::overlaps, so all versions give the same masks.
+class CollisionKernels {
+public:
+	enum class Path { scalar, sse, avx2 };
+
+	static Path best_path(void);
+	static bool available(Path path);
+	static const char* path_name(Path path);
+
+	static std::size_t mask_words(std::size_t boxes) { return (boxes + 31) / 32; }
+
+	// query box against all boxes; mask needs mask_words(boxes.size()) words
+	static unsigned int overlap(const BoxSoA& boxes, const Aabb& query, std::uint32_t* mask, Path path = best_path());
+
+	// ray against all boxes, hits in (0, t_max); t[i] is the entry distance of a hit box (0 when the origin is inside),
+	// t can be nullptr; a ray lying exactly in a box face may go either way
+	static unsigned int raycast(const BoxSoA& boxes, const glm::vec3& origin, const glm::vec3& direction, float t_max,
+		std::uint32_t* mask, float* t, Path path = best_path());
+
+	// every box of a against every box of b; row i of masks (mask_words(b.size()) words) holds the hits of a[i]
+	static unsigned int overlap_tile(const BoxSoA& a, const BoxSoA& b, std::uint32_t* masks, Path path = best_path());
+};
@@ -0,0 +1,258 @@
+#include <algorithm>
+
+#include "DynamicAabbTree.h"
+
+std::int32_t DynamicAabbTree::allocate(void)
+{
+	if (free_list == null) {
+		nodes.emplace_back();
+		return static_cast<std::int32_t>(nodes.size() - 1);
+	}
+	std::int32_t n = free_list;
+	free_list = nodes[n].parent;
+	nodes[n] = Node();
+	return n;
+}
+
+void DynamicAabbTree::release(std::int32_t n)
+{
+	nodes[n].parent = free_list;
+	nodes[n].height = -1;
+	free_list = n;
+}
+
+std::int32_t DynamicAabbTree::insert(const Aabb& box, std::uint32_t user)
+{
+	std::int32_t leaf = allocate();
+	nodes[leaf].box = box.expanded(margin);
+	nodes[leaf].user = user;
+	nodes[leaf].height = 0;
+	insert_leaf(leaf);
+	leaves++;
+	return leaf;
+}
+
+void DynamicAabbTree::remove(std::int32_t proxy)
+{
+	remove_leaf(proxy);
+	release(proxy);
+	leaves--;
+}
+
+bool DynamicAabbTree::move(std::int32_t proxy, const Aabb& box)
+{
+	if (nodes[proxy].box.contains(box))
+		return false;
+
+	remove_leaf(proxy);
+	nodes[proxy].box = box.expanded(margin);
+	insert_leaf(proxy);
+	return true;
+}
+
+void DynamicAabbTree::clear(void)
+{
+	nodes.clear();
+	root = null;
+	free_list = null;
+	leaves = 0;
+}
+
+void DynamicAabbTree::insert_leaf(std::int32_t leaf)
+{
+	if (root == null) {
+		root = leaf;
+		nodes[root].parent = null;
+		return;
+	}
+
+	// find the best sibling: descend while the cost of going down beats pairing here
+	const Aabb leaf_box = nodes[leaf].box; // copy, allocate() may move the nodes
+	std::int32_t index = root;
+	while (!nodes[index].leaf()) {
+		std::int32_t child1 = nodes[index].child1;
+		std::int32_t child2 = nodes[index].child2;
+
+		float area = nodes[index].box.surface_area();
+		float combined_area = nodes[index].box.merged(leaf_box).surface_area();
+
+		// cost of a new parent for this node and the leaf
+		float cost = 2.0f * combined_area;
+		// minimum cost of pushing the leaf further down
+		float inheritance_cost = 2.0f * (combined_area - area);
+
+		auto descend_cost = [&](std::int32_t child) {
+			float merged = nodes[child].box.merged(leaf_box).surface_area();
+			if (nodes[child].leaf())
+				return merged + inheritance_cost;
+			return merged - nodes[child].box.surface_area() + inheritance_cost;
+		};
+		float cost1 = descend_cost(child1);
+		float cost2 = descend_cost(child2);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+		index = (cost1 < cost2) ? child1 : child2;
+	}
+	std::int32_t sibling = index;
+
+	// new parent in place of the sibling
+	std::int32_t old_parent = nodes[sibling].parent;
+	std::int32_t new_parent = allocate();
+	nodes[new_parent].parent = old_parent;
+	nodes[new_parent].box = leaf_box.merged(nodes[sibling].box);
+	nodes[new_parent].height = nodes[sibling].height + 1;
+	nodes[new_parent].child1 = sibling;
+	nodes[new_parent].child2 = leaf;
+	nodes[sibling].parent = new_parent;
+	nodes[leaf].parent = new_parent;
+
+	if (old_parent == null) {
+		root = new_parent;
+	}
+	else {
+		if (nodes[old_parent].child1 == sibling)
+			nodes[old_parent].child1 = new_parent;
+		else
+			nodes[old_parent].child2 = new_parent;
+	}
+
+	refit(nodes[leaf].parent);
+}
+
+void DynamicAabbTree::remove_leaf(std::int32_t leaf)
+{
+	if (leaf == root) {
+		root = null;
+		return;
+	}
+
+	std::int32_t parent = nodes[leaf].parent;
+	std::int32_t grand_parent = nodes[parent].parent;
+	std::int32_t sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+	// the sibling takes the place of the parent
+	if (grand_parent == null) {
+		root = sibling;
+		nodes[sibling].parent = null;
+		release(parent);
+		return;
+	}
+
+	if (nodes[grand_parent].child1 == parent)
+		nodes[grand_parent].child1 = sibling;
+	else
+		nodes[grand_parent].child2 = sibling;
+	nodes[sibling].parent = grand_parent;
+	release(parent);
+
+	refit(grand_parent);
+}
+
+void DynamicAabbTree::refit(std::int32_t n)
+{
+	while (n != null) {
+		n = balance(n);
+
+		std::int32_t child1 = nodes[n].child1;
+		std::int32_t child2 = nodes[n].child2;
+		nodes[n].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+		nodes[n].box = nodes[child1].box.merged(nodes[child2].box);
+
+		n = nodes[n].parent;
+	}
+}
+
+// rotate the taller child up if a is imbalanced; returns the node now in a's place
+std::int32_t DynamicAabbTree::balance(std::int32_t ia)
+{
+	Node& a = nodes[ia];
+	if (a.leaf() || a.height < 2)
+		return ia;
+
+	std::int32_t ib = a.child1;
+	std::int32_t ic = a.child2;
+	int diff = nodes[ic].height - nodes[ib].height;
+
+	// lift c (right) or b (left) into a's position
+	auto rotate_up = [&](std::int32_t up, std::int32_t other, bool up_is_child2) {
+		Node& u = nodes[up];
+		std::int32_t f = u.child1;
+		std::int32_t g = u.child2;
+
+		u.child1 = ia;
+		u.parent = nodes[ia].parent;
+		nodes[ia].parent = up;
+
+		if (u.parent != null) {
+			if (nodes[u.parent].child1 == ia)
+				nodes[u.parent].child1 = up;
+			else
+				nodes[u.parent].child2 = up;
+		}
+		else {
+			root = up;
+		}
+
+		// the taller grandchild stays under up, the other one replaces up under a
+		std::int32_t keep = (nodes[f].height > nodes[g].height) ? f : g;
+		std::int32_t give = (keep == f) ? g : f;
+		u.child2 = keep;
+		if (up_is_child2)
+			nodes[ia].child2 = give;
+		else
+			nodes[ia].child1 = give;
+		nodes[give].parent = ia;
+
+		nodes[ia].box = nodes[other].box.merged(nodes[give].box);
+		nodes[up].box = nodes[ia].box.merged(nodes[keep].box);
+		nodes[ia].height = 1 + std::max(nodes[other].height, nodes[give].height);
+		nodes[up].height = 1 + std::max(nodes[ia].height, nodes[keep].height);
+		return up;
+	};
+
+	if (diff > 1)
+		return rotate_up(ic, ib, true);
+	if (diff < -1)
+		return rotate_up(ib, ic, false);
+	return ia;
+}
+
+void DynamicAabbTree::validate(void) const
+{
+	if (root != null && nodes[root].parent != null)
+		throw std::exception("DynamicAabbTree: root has a parent");
+	validate(root);
+
+	unsigned int free_count = 0;
+	for (std::int32_t n = free_list; n != null; n = nodes[n].parent)
+		free_count++;
+	unsigned int reachable = (root == null) ? 0 : 2 * leaves - 1;
+	if (reachable + free_count != nodes.size())
+		throw std::exception("DynamicAabbTree: node count mismatch");
+}
+
+void DynamicAabbTree::validate(std::int32_t n) const
+{
+	if (n == null)
+		return;
+
+	const Node& node = nodes[n];
+	if (node.leaf()) {
+		if (node.child2 != null || node.height != 0)
+			throw std::exception("DynamicAabbTree: broken leaf");
+		return;
+	}
+
+	const Node& c1 = nodes[node.child1];
+	const Node& c2 = nodes[node.child2];
+	if (c1.parent != n || c2.parent != n)
+		throw std::exception("DynamicAabbTree: broken parent link");
+	if (node.height != 1 + std::max(c1.height, c2.height))
+		throw std::exception("DynamicAabbTree: wrong height");
+	if (!node.box.contains(c1.box) || !node.box.contains(c2.box))
+		throw std::exception("DynamicAabbTree: box does not enclose children");
+
+	validate(node.child1);
+	validate(node.child2);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Aabb.h"
+
+// Dynamic bounding volume tree for moving objects
+//
+// Leaves hold fattened boxes (margin around the real box), so an object that moves
+// a little stays inside its leaf and move() costs nothing; only when it leaves the
+// fat box is the leaf removed and reinserted. Insertion descends by the surface
+// area cost of enlarging each branch, and AVL-like rotations keep the tree
+// balanced, so queries stay logarithmic under constant movement.
+// Proxies are node indices and stay valid until remove().
+class DynamicAabbTree {
+public:
+	static constexpr std::int32_t null = -1;
+
+	float margin = 0.2f; // fattening on every side
+
+	DynamicAabbTree(void) = default;
+	DynamicAabbTree(const DynamicAabbTree&) = delete;
+
+	std::int32_t insert(const Aabb& box, std::uint32_t user);
+	void remove(std::int32_t proxy);
+	// true if the proxy had to be reinserted
+	bool move(std::int32_t proxy, const Aabb& box);
+	void clear(void);
+
+	// fn(proxy) for every leaf whose fat box overlaps box
+	template<typename F>
+	void query(const Aabb& box, F&& fn) const;
+	// fn(proxy_a, proxy_b) once for every pair of leaves with overlapping fat boxes
+	template<typename F>
+	void query_pairs(F&& fn) const;
+
+	std::uint32_t user(std::int32_t proxy) const { return nodes[proxy].user; }
+	const Aabb& fat_box(std::int32_t proxy) const { return nodes[proxy].box; }
+	int height(void) const { return root == null ? 0 : nodes[root].height; }
+	unsigned int leaf_count(void) const { return leaves; }
+
+	// throws if parent links, heights or enclosing boxes are inconsistent
+	void validate(void) const;
+
+private:
+	static constexpr int local_stack = 64; // query depth before the stack moves to the heap
+
+	struct Node {
+		Aabb box;
+		std::int32_t parent = null; // next free node while on the free list
+		std::int32_t child1 = null;
+		std::int32_t child2 = null;
+		std::int32_t height = 0;    // leaf = 0, free = -1
+		std::uint32_t user = 0;
+
+		bool leaf(void) const { return child1 == null; }
+	};
+
+	std::int32_t allocate(void);
+	void release(std::int32_t n);
+	void insert_leaf(std::int32_t leaf);
+	void remove_leaf(std::int32_t leaf);
+	std::int32_t balance(std::int32_t a);
+	void refit(std::int32_t n); // from n up to the root
+	void validate(std::int32_t n) const;
+
+	std::vector<Node> nodes;
+	std::int32_t root = null;
+	std::int32_t free_list = null;
+	unsigned int leaves = 0;
+};
+
+template<typename F>
+void DynamicAabbTree::query(const Aabb& box, F&& fn) const
+{
+	if (root == null)
+		return;
+
+	// balanced trees fit the local stack, the vector only takes what a degenerate one pushes beyond it
+	std::int32_t stack[local_stack];
+	std::vector<std::int32_t> spill;
+	int top = 0;
+	auto push = [&](std::int32_t n) {
+		if (top < local_stack)
+			stack[top++] = n;
+		else
+			spill.push_back(n);
+	};
+
+	push(root);
+	while (top > 0) {
+		std::int32_t n;
+		if (!spill.empty()) {
+			n = spill.back();
+			spill.pop_back();
+		}
+		else {
+			n = stack[--top];
+		}
+		const Node& node = nodes[n];
+		if (!node.box.overlaps(box))
+			continue;
+		if (node.leaf()) {
+			fn(n);
+		}
+		else {
+			push(node.child1);
+			push(node.child2);
+		}
+	}
+}
+
+template<typename F>
+void DynamicAabbTree::query_pairs(F&& fn) const
+{
+	// every leaf queries the tree, a pair is reported from its lower proxy only
+	for (std::int32_t i = 0; i < static_cast<std::int32_t>(nodes.size()); ++i) {
+		if (nodes[i].height != 0)
+			continue;
+		query(nodes[i].box, [&](std::int32_t other) {
+			if (other > i)
+				fn(i, other);
+		});
+	}
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+
+#include "DynamicResolution.h"
+#include "GLState.h"
+
+void DynamicResolution::init(void)
+{
+	upscale_shader = ShaderProgram("resources/shaders/upscale.vert", "resources/shaders/upscale.frag");
+	glGenVertexArrays(1, &empty_vao); // fullscreen triangle comes from gl_VertexID
+	glGenQueries(query_count, queries);
+}
+
+void DynamicResolution::resize(int width, int height)
+{
+	if (framebuffer == 0) {
+		glGenFramebuffers(1, &framebuffer);
+		glGenTextures(1, &color_texture);
+		glGenRenderbuffers(1, &depth_buffer);
+	}
+	target_w = width;
+	target_h = height;
+
+	GLState::activeTexture(GL_TEXTURE0);
+	GLState::bindTexture(GL_TEXTURE_2D, color_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth_buffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::exception("Dynamic resolution framebuffer incomplete");
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DynamicResolution::begin(int width, int height)
+{
+	window_w = std::max(width, 1);
+	window_h = std::max(height, 1);
+
+	// oldest query has had query_count frames to finish
+	GLuint query = queries[query_index];
+	if (query_pending[query_index]) {
+		GLint available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			GLuint64 ns = 0;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+			update_scale(ns / 1e6);
+		}
+		// an unavailable result is dropped, reusing the query restarts it
+		query_pending[query_index] = false;
+	}
+	glBeginQuery(GL_TIME_ELAPSED, query);
+	query_pending[query_index] = true;
+
+	if (enabled) {
+		if (target_w != window_w || target_h != window_h)
+			resize(window_w, window_h);
+		render_w = std::max(1, static_cast<int>(std::lround(window_w * current_scale)));
+		render_h = std::max(1, static_cast<int>(std::lround(window_h * current_scale)));
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+	else {
+		render_w = window_w;
+		render_h = window_h;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+	glViewport(0, 0, render_w, render_h);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DynamicResolution::end(void)
+{
+	if (enabled) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, window_w, window_h);
+
+		// fullscreen triangle, no depth, no blending
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+		upscale_shader.activate();
+		upscale_shader.setUniform("source", 0);
+		upscale_shader.setUniform("uvScale", glm::vec2(static_cast<float>(render_w) / target_w, static_cast<float>(render_h) / target_h));
+		upscale_shader.setUniform("texelSize", glm::vec2(1.0f / target_w, 1.0f / target_h));
+		float fade = (max_scale > min_scale) ? (max_scale - current_scale) / (max_scale - min_scale) : 0.0f;
+		upscale_shader.setUniform("sharpness", sharpness * glm::clamp(fade, 0.0f, 1.0f));
+		GLState::activeTexture(GL_TEXTURE0);
+		GLState::bindTexture(GL_TEXTURE_2D, color_texture);
+		GLState::bindVertexArray(empty_vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glEnable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+	}
+
+	glEndQuery(GL_TIME_ELAPSED);
+	query_index = (query_index + 1) % query_count;
+}
+
+void DynamicResolution::update_scale(double frame_ms)
+{
+	smoothed_ms = (smoothed_ms == 0.0) ? frame_ms : smoothed_ms * 0.9 + frame_ms * 0.1;
+
+	if (!enabled || ++frames_since_change < cooldown_frames)
+		return;
+	if (std::abs(smoothed_ms - target_ms) <= target_ms * hysteresis)
+		return;
+
+	// shading cost goes with the pixel count, i.e. scale squared
+	float wanted = current_scale * static_cast<float>(std::sqrt(target_ms / smoothed_ms));
+	wanted = glm::clamp(wanted, current_scale - max_step, current_scale + max_step);
+	wanted = glm::clamp(wanted, min_scale, max_scale);
+	if (wanted != current_scale) {
+		current_scale = wanted;
+		frames_since_change = 0;
+	}
+}
+
+void DynamicResolution::clear(void)
+{
+	upscale_shader.clear();
+	if (empty_vao != 0)
+		GLState::deleteVertexArrays(1, &empty_vao);
+	if (color_texture != 0)
+		GLState::deleteTextures(1, &color_texture);
+	glDeleteRenderbuffers(1, &depth_buffer);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteQueries(query_count, queries);
+	empty_vao = color_texture = depth_buffer = framebuffer = 0;
+	target_w = target_h = 0;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+// OpenGL Extension Wrangler
+#include <GL/glew.h>
+#include <GL/wglew.h> //WGLEW = Windows GL Extension Wrangler (change for different platform)
+
+#include "ShaderProgram.h"
+
+// Adaptive render scale driven by GPU frame time
+//
+// The scene is rendered into the lower left part of an offscreen framebuffer of
+// window size, then upscaled to the window with a sharpening filter. GPU time of
+// each frame is measured with GL_TIME_ELAPSED queries (read a few frames later,
+// never stalling) and a controller moves the scale towards target_ms. The scale
+// only changes when the smoothed time leaves the hysteresis band around the
+// target, and at most every cooldown_frames.
+class DynamicResolution {
+public:
+	// controller settings
+	bool enabled = true;
+	double target_ms = 1000.0 / 60.0;
+	float min_scale = 0.5f;
+	float max_scale = 1.0f;
+	float max_step = 0.1f;       // largest scale change per adjustment
+	double hysteresis = 0.1;     // no change while within target +-10 %
+	int cooldown_frames = 15;
+	float sharpness = 0.5f;      // upscale sharpening at min_scale, fades out towards scale 1
+
+	DynamicResolution(void) = default;
+	DynamicResolution(const DynamicResolution&) = delete;
+
+	void init(void); // needs GL context
+	// bind the target for this frame, set viewport and clear; width, height = window framebuffer
+	void begin(int width, int height);
+	// stop timing, upscale to the default framebuffer, adjust the scale
+	void end(void);
+	void clear(void);
+
+	float scale(void) const { return enabled ? current_scale : 1.0f; }
+	int render_width(void) const { return render_w; }
+	int render_height(void) const { return render_h; }
+	double gpu_ms(void) const { return smoothed_ms; }
+
+private:
+	static constexpr int query_count = 4; // frames in flight before a result is read
+
+	void resize(int width, int height);
+	void update_scale(double frame_ms);
+
+	ShaderProgram upscale_shader;
+	GLuint empty_vao = 0;
+	GLuint framebuffer = 0;
+	GLuint color_texture = 0;
+	GLuint depth_buffer = 0;
+	int target_w = 0, target_h = 0;   // allocated size
+	int window_w = 0, window_h = 0;
+	int render_w = 0, render_h = 0;
+
+	GLuint queries[query_count] = {};
+	bool query_pending[query_count] = {};
+	int query_index = 0;
+
+	float current_scale = 1.0f;
+	double smoothed_ms = 0.0;
+	int frames_since_change = 0;
+};
@@ -0,0 +1,110 @@
+#include "EntityStore.h"
+
+Entity EntityStore::create(std::unique_ptr<Mesh> m, const std::string& name)
+{
+	Entity e;
+	if (!free_indices.empty()) {
+		e.index = free_indices.back();
+		free_indices.pop_back();
+	}
+	else {
+		e.index = static_cast<std::uint32_t>(sparse_slot.size());
+		sparse_slot.push_back(0);
+		sparse_generation.push_back(0);
+	}
+	e.generation = sparse_generation[e.index];
+	sparse_slot[e.index] = size();
+	dense_entity.push_back(e);
+
+	position.push_back(glm::vec3(0.0f));
+	orientation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	scale.push_back(glm::vec3(1.0f));
+	transform.push_back(0xFFFFFFFFu);
+	dimensions.push_back(glm::vec3(1.0f));
+	simulated.push_back(0);
+	velocity.push_back(glm::vec3(0.0f));
+	spin.push_back(glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+	spin_angle.push_back(0.0f);
+	mesh.push_back(std::move(m));
+
+	if (!name.empty())
+		names[name] = e;
+	return e;
+}
+
+void EntityStore::destroy(Entity e)
+{
+	if (!alive(e))
+		return;
+
+	std::uint32_t hole = sparse_slot[e.index];
+	std::uint32_t last = size() - 1;
+
+	move_last(position, hole);
+	move_last(orientation, hole);
+	move_last(scale, hole);
+	move_last(transform, hole);
+	move_last(dimensions, hole);
+	move_last(simulated, hole);
+	move_last(velocity, hole);
+	move_last(spin, hole);
+	move_last(spin_angle, hole);
+	move_last(mesh, hole);
+
+	if (hole != last) {
+		dense_entity[hole] = dense_entity[last];
+		sparse_slot[dense_entity[hole].index] = hole;
+	}
+	dense_entity.pop_back();
+
+	// old handles now fail alive()
+	sparse_generation[e.index]++;
+	free_indices.push_back(e.index);
+
+	for (auto it = names.begin(); it != names.end(); ++it) {
+		if (it->second == e) {
+			names.erase(it);
+			break;
+		}
+	}
+}
+
+void EntityStore::clear(void)
+{
+	position.clear();
+	orientation.clear();
+	scale.clear();
+	transform.clear();
+	dimensions.clear();
+	simulated.clear();
+	velocity.clear();
+	spin.clear();
+	spin_angle.clear();
+	mesh.clear();
+
+	sparse_slot.clear();
+	sparse_generation.clear();
+	free_indices.clear();
+	dense_entity.clear();
+	names.clear();
+}
+
+bool EntityStore::alive(Entity e) const
+{
+	return e.valid() && e.index < sparse_generation.size() && sparse_generation[e.index] == e.generation;
+}
+
+Entity EntityStore::find(const std::string& name) const
+{
+	auto it = names.find(name);
+	if (it == names.end() || !alive(it->second))
+		return Entity();
+	return it->second;
+}
+
+std::uint32_t EntityStore::slot(Entity e) const
+{
+	if (!alive(e))
+		throw std::exception("EntityStore: dead entity handle");
+	return sparse_slot[e.index];
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Mesh.h"
+
+// Handle to an entity; stale handles of destroyed entities are detected by the generation
+struct Entity {
+	static constexpr std::uint32_t invalid_index = 0xFFFFFFFFu;
+
+	std::uint32_t index = invalid_index; // into the sparse slot table, not the component arrays
+	std::uint32_t generation = 0;
+
+	bool valid(void) const { return index != invalid_index; }
+	bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+// Scene objects as packed struct-of-arrays components
+//
+// Every component is a vector indexed by the dense slot 0..size()-1, so passes over
+// one component (collision over position and dimensions, motion, draw submission)
+// walk contiguous memory. destroy() moves the last entity into the freed slot to keep
+// the arrays packed; handles stay valid through the sparse table, dense slots do not.
+// Names are optional and only used for lookups at setup time.
+class EntityStore {
+public:
+	EntityStore(void) = default;
+	EntityStore(const EntityStore&) = delete;
+
+	// empty name = not in the name index
+	Entity create(std::unique_ptr<Mesh> mesh, const std::string& name = std::string());
+	void destroy(Entity e);
+	void clear(void);
+
+	bool alive(Entity e) const;
+	Entity find(const std::string& name) const; // invalid handle if unknown
+	std::uint32_t slot(Entity e) const;         // dense index of a live entity
+	Entity entity(std::uint32_t slot) const { return dense_entity[slot]; }
+	std::uint32_t size(void) const { return static_cast<std::uint32_t>(position.size()); }
+
+	// transform
+	std::vector<glm::vec3> position;
+	std::vector<glm::quat> orientation;
+	std::vector<glm::vec3> scale;
+	std::vector<std::uint32_t> transform; // node in the renderer's TransformSystem
+	// bounds: axis aligned box of this size centered at position
+	std::vector<glm::vec3> dimensions;
+	// motion, simulated entities only move when flagged
+	std::vector<std::uint8_t> simulated;
+	std::vector<glm::vec3> velocity;     // units per second, scaled by the ping-pong direction
+	std::vector<glm::vec4> spin;         // axis xyz (normalized), degrees per second w
+	std::vector<float> spin_angle;       // degrees, wrapped to [0, 360)
+	// render data, meshes keep their address for the GL side registrations
+	std::vector<std::unique_ptr<Mesh>> mesh;
+
+private:
+	template<typename T>
+	static void move_last(std::vector<T>& v, std::uint32_t to) {
+		v[to] = std::move(v.back());
+		v.pop_back();
+	}
+
+	std::vector<std::uint32_t> sparse_slot;      // entity index -> dense slot
+	std::vector<std::uint32_t> sparse_generation;
+	std::vector<std::uint32_t> free_indices;
+	std::vector<Entity> dense_entity;            // dense slot -> entity
+	std::unordered_map<std::string, Entity> names;
+};
@@ -0,0 +1,139 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "FrameLimiter.h"
+
+static constexpr double min_margin_ms = 0.2;
+static constexpr double max_margin_ms = 4.0;
+
+FrameLimiter::FrameLimiter(void)
+{
+#ifdef _WIN32
+	// default scheduler tick is 15.6 ms, far too coarse to sleep inside a frame
+	timeBeginPeriod(1);
+#endif
+}
+
+FrameLimiter::~FrameLimiter(void)
+{
+#ifdef _WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void FrameLimiter::wait(void)
+{
+	if (mode == Mode::limited && target_fps > 0.0) {
+		auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / target_fps));
+		auto now = clock::now();
+
+		// fell behind by more than a frame: start a new grid instead of catching up
+		if (!has_deadline || now - deadline > period)
+			deadline = now;
+		deadline += period;
+		has_deadline = true;
+
+		sleep_until(deadline);
+	}
+	else {
+		has_deadline = false;
+	}
+
+	record(clock::now());
+}
+
+void FrameLimiter::sleep_until(clock::time_point target)
+{
+	using ms = std::chrono::duration<double, std::milli>;
+
+	// coarse part: 1 ms sleeps while the deadline is further away than the margin
+	for (;;) {
+		double margin = std::clamp(oversleep_ms * 1.5, min_margin_ms, max_margin_ms);
+		auto before = clock::now();
+		if (ms(target - before).count() <= 1.0 + margin)
+			break;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		// learn quickly when the timer gets worse, forget slowly when it gets better
+		double over = ms(clock::now() - before).count() - 1.0;
+		oversleep_ms = (over > oversleep_ms) ? over : oversleep_ms * 0.95 + over * 0.05;
+	}
+
+	// fine part: spin the last fraction of a millisecond
+	auto spin_start = clock::now();
+	while (clock::now() < target)
+		std::this_thread::yield();
+	spin_total_ms += ms(clock::now() - spin_start).count();
+}
+
+void FrameLimiter::record(clock::time_point t)
+{
+	if (has_last_frame) {
+		double x = std::chrono::duration<double, std::milli>(t - last_frame).count();
+
+		++count;
+		double d = x - mean;
+		mean += d / count;
+		m2 += d * (x - mean);
+		min_interval = (count == 1) ? x : std::min(min_interval, x);
+		max_interval = (count == 1) ? x : std::max(max_interval, x);
+	}
+	last_frame = t;
+	has_last_frame = true;
+}
+
+void FrameLimiter::reset(void)
+{
+	has_deadline = false;
+	has_last_frame = false; // idle gap is not a frame interval
+}
+
+void FrameLimiter::next_mode(void)
+{
+	switch (mode) {
+	case Mode::unlimited: mode = Mode::limited; break;
+	case Mode::limited: mode = Mode::on_demand; break;
+	default: mode = Mode::unlimited; break;
+	}
+	reset();
+	reset_stats();
+}
+
+const char* FrameLimiter::mode_name(void) const
+{
+	switch (mode) {
+	case Mode::limited: return "limited";
+	case Mode::on_demand: return "on demand";
+	default: return "unlimited";
+	}
+}
+
+FrameLimiter::Stats FrameLimiter::stats(void) const
+{
+	Stats s;
+	s.frames = count;
+	if (count > 0) {
+		s.mean_ms = mean;
+		s.stddev_ms = (count > 1) ? std::sqrt(m2 / (count - 1)) : 0.0;
+		s.min_ms = min_interval;
+		s.max_ms = max_interval;
+		s.spin_ms = spin_total_ms / count;
+	}
+	s.margin_ms = std::clamp(oversleep_ms * 1.5, min_margin_ms, max_margin_ms);
+	return s;
+}
+
+void FrameLimiter::reset_stats(void)
+{
+	count = 0;
+	mean = m2 = min_interval = max_interval = 0.0;
+	spin_total_ms = 0.0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+
+// Frame pacing independent of vsync
+//
+// limited: frames are released on a fixed deadline grid of 1 / target_fps. The
+// wait sleeps while the deadline is far away, keeping a safety margin that adapts
+// to the measured oversleep of the OS timer, and spins on the high resolution
+// clock for the rest, so the frame leaves within microseconds of its deadline.
+// A frame that misses its deadline by more than a period restarts the grid
+// instead of bursting frames to catch up.
+// on_demand: the application renders only after input or a state change and
+// blocks in the event queue otherwise (see idle_timeout).
+// Frame-to-frame intervals, measured where wait() returns, are accumulated until
+// reset_stats() for mean, standard deviation and extremes.
+class FrameLimiter {
+public:
+	enum class Mode { unlimited, limited, on_demand };
+
+	Mode mode = Mode::unlimited;
+	double target_fps = 60.0;
+	double idle_timeout = 0.25; // seconds, on_demand wakes up at least this often
+
+	struct Stats {
+		unsigned int frames = 0;
+		double mean_ms = 0.0;
+		double stddev_ms = 0.0;
+		double min_ms = 0.0;
+		double max_ms = 0.0;
+		double spin_ms = 0.0;   // busy waiting per frame, average
+		double margin_ms = 0.0; // current sleep safety margin
+	};
+
+	FrameLimiter(void);
+	FrameLimiter(const FrameLimiter&) = delete;
+	~FrameLimiter(void);
+
+	// once per frame, right before presenting
+	void wait(void);
+	// restart the deadline grid, e.g. after idling or a mode change
+	void reset(void);
+
+	void next_mode(void);
+	const char* mode_name(void) const;
+
+	Stats stats(void) const;
+	void reset_stats(void);
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	void sleep_until(clock::time_point deadline);
+	void record(clock::time_point t);
+
+	clock::time_point deadline;
+	bool has_deadline = false;
+
+	// observed oversleep of a short sleep, smoothed, in ms
+	double oversleep_ms = 1.0;
+
+	// Welford accumulators over the frame intervals
+	clock::time_point last_frame;
+	bool has_last_frame = false;
+	unsigned int count = 0;
+	double mean = 0.0, m2 = 0.0, min_interval = 0.0, max_interval = 0.0;
+	double spin_total_ms = 0.0;
+};
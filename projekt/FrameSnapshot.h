@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+class Mesh;
+
+// Keys and view direction sampled by the render thread, consumed by the simulation
+struct SimInput {
+	bool keys[6] = {}; // indexed by Camera::direction
+	glm::vec3 front = glm::vec3(0.0f, 0.0f, -1.0f);
+	glm::vec3 right = glm::vec3(1.0f, 0.0f, 0.0f);
+	glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+	std::chrono::steady_clock::time_point sampled;
+};
+
+// Immutable result of one simulation step, handed to the render thread
+//
+// Holds the state before and after the step, so the renderer can interpolate
+// between them while the simulation already computes the next one.
+struct FrameSnapshot {
+	struct Object {
+		Mesh* mesh;
+		std::uint32_t slot; // dense slot in the EntityStore
+		glm::vec3 previous_position, position;
+		glm::quat previous_orientation, orientation;
+		glm::vec3 scale;
+
+		// alpha 0 = before the step, 1 = after
+		glm::vec3 position_at(float alpha) const { return glm::mix(previous_position, position, alpha); }
+		glm::quat orientation_at(float alpha) const { return glm::slerp(previous_orientation, orientation, alpha); }
+	};
+
+	std::uint64_t sequence = 0; // 0 = nothing simulated yet
+	double sim_time = 0.0;      // seconds, after the step
+	std::chrono::steady_clock::time_point step_time;  // grid time the step was due
+	std::chrono::steady_clock::time_point input_time; // when its input was sampled
+	glm::vec3 previous_camera_position = glm::vec3(0.0f);
+	glm::vec3 camera_position = glm::vec3(0.0f);
+	bool moved = false; // anything changed in this step
+	std::vector<Object> objects;
+};
@@ -0,0 +1,110 @@
+#include "GLState.h"
+
+GLuint GLState::program = GLState::unknown;
+GLenum GLState::active_unit = GLState::unknown;
+GLuint GLState::textures[GLState::max_units][GLState::max_targets] = {};
+GLuint GLState::vao = GLState::unknown;
+
+GLState::Counters GLState::current;
+GLState::Counters GLState::last;
+
+int GLState::targetIndex(GLenum target)
+{
+	switch (target) {
+	case GL_TEXTURE_2D:
+		return 0;
+	case GL_TEXTURE_2D_ARRAY:
+		return 1;
+	default:
+		return -1; // not tracked
+	}
+}
+
+void GLState::useProgram(GLuint p)
+{
+	if (program == p) {
+		current.skipped++;
+		return;
+	}
+	glUseProgram(p);
+	program = p;
+	current.issued++;
+}
+
+void GLState::activeTexture(GLenum unit)
+{
+	if (active_unit == unit) {
+		current.skipped++;
+		return;
+	}
+	glActiveTexture(unit);
+	active_unit = unit;
+	current.issued++;
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+	int t = targetIndex(target);
+	int u = (active_unit == unknown) ? -1 : static_cast<int>(active_unit - GL_TEXTURE0);
+
+	if (t < 0 || u < 0 || u >= max_units) {
+		glBindTexture(target, texture);
+		current.issued++;
+		return;
+	}
+
+	if (textures[u][t] == texture) {
+		current.skipped++;
+		return;
+	}
+	glBindTexture(target, texture);
+	textures[u][t] = texture;
+	current.issued++;
+}
+
+void GLState::bindVertexArray(GLuint v)
+{
+	if (vao == v) {
+		current.skipped++;
+		return;
+	}
+	glBindVertexArray(v);
+	vao = v;
+	current.issued++;
+}
+
+void GLState::deleteTextures(GLsizei n, const GLuint* ids)
+{
+	// deleted textures are unbound by GL, the name may be reused for a new texture
+	for (GLsizei i = 0; i < n; ++i)
+		for (auto& unit : textures)
+			for (auto& bound : unit)
+				if (bound == ids[i])
+					bound = 0;
+	glDeleteTextures(n, ids);
+}
+
+void GLState::deleteProgram(GLuint p)
+{
+	if (program == p)
+		program = unknown; // stays in use until another program is activated
+	glDeleteProgram(p);
+}
+
+void GLState::deleteVertexArrays(GLsizei n, const GLuint* ids)
+{
+	for (GLsizei i = 0; i < n; ++i)
+		if (vao == ids[i])
+			vao = 0;
+	glDeleteVertexArrays(n, ids);
+}
+
+void GLState::invalidate(void)
+{
+	program = unknown;
+	active_unit = unknown;
+	for (auto& unit : textures)
+		for (auto& bound : unit)
+			bound = unknown;
+	vao = unknown;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// OpenGL Extension Wrangler
+#include <GL/glew.h>
+#include <GL/wglew.h> //WGLEW = Windows GL Extension Wrangler (change for different platform)
+
+// Shadow copy of frequently switched GL binding state
+//
+// Program, active texture unit, texture and VAO binds go through here; a call that
+// would not change the current state is skipped. All code binding these objects
+// directly must call invalidate() afterwards, deletions must go through here too.
+class GLState {
+public:
+	struct Counters {
+		unsigned int issued = 0;
+		unsigned int skipped = 0;
+	};
+
+	static void useProgram(GLuint program);
+	static void activeTexture(GLenum unit);      // GL_TEXTURE0 + i
+	static void bindTexture(GLenum target, GLuint texture); // on active unit
+	static void bindVertexArray(GLuint vao);
+
+	static void deleteTextures(GLsizei n, const GLuint* textures);
+	static void deleteProgram(GLuint program);
+	static void deleteVertexArrays(GLsizei n, const GLuint* vaos);
+
+	// forget everything, next bind of each kind is issued
+	static void invalidate(void);
+
+	// counters of the frame in progress and of the last finished frame
+	static const Counters& counters(void) { return current; }
+	static const Counters& lastFrame(void) { return last; }
+	static void endFrame(void) { last = current; current = Counters(); }
+
+private:
+	static constexpr int max_units = 16;
+	static constexpr int max_targets = 2; // GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY
+	static constexpr GLuint unknown = 0xffffffff;
+
+	static int targetIndex(GLenum target);
+
+	static GLuint program;
+	static GLenum active_unit;
+	static GLuint textures[max_units][max_targets];
+	static GLuint vao;
+
+	static Counters current;
+	static Counters last;
+};
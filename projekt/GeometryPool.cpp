@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <iostream>
+
+#include "GeometryPool.h"
+#include "GLState.h"
+
+//
+// RangeAllocator
+//
+
+std::size_t RangeAllocator::allocate(std::size_t count)
+{
+	if (count == 0)
+		return 0;
+
+	for (auto it = free_blocks.begin(); it != free_blocks.end(); ++it) {
+		if (it->second < count)
+			continue;
+
+		std::size_t offset = it->first;
+		std::size_t remaining = it->second - count;
+		free_blocks.erase(it);
+		if (remaining > 0)
+			free_blocks.emplace(offset + count, remaining);
+
+		in_use += count;
+		return offset;
+	}
+	return invalid;
+}
+
+void RangeAllocator::free(std::size_t offset, std::size_t count)
+{
+	if (count == 0)
+		return;
+
+	in_use -= count;
+	auto it = free_blocks.emplace(offset, count).first;
+
+	// merge with following block
+	auto next = std::next(it);
+	if (next != free_blocks.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		free_blocks.erase(next);
+	}
+	// merge with preceding block
+	if (it != free_blocks.begin()) {
+		auto prev = std::prev(it);
+		if (prev->first + prev->second == it->first) {
+			prev->second += it->second;
+			free_blocks.erase(it);
+		}
+	}
+}
+
+void RangeAllocator::grow(std::size_t new_capacity)
+{
+	if (new_capacity <= total)
+		return;
+
+	std::size_t added = new_capacity - total;
+	std::size_t offset = total;
+	total = new_capacity;
+	in_use += added; // free() subtracts it again
+	free(offset, added);
+}
+
+//
+// GeometryPool
+//
+
+GeometryPool& GeometryPool::get(void)
+{
+	static GeometryPool pool;
+	return pool;
+}
+
+void GeometryPool::init(void)
+{
+	glGenVertexArrays(1, &VAO_ID);
+	glGenVertexArrays(1, &depth_VAO_ID);
+
+	glGenBuffers(1, &VBO_ID);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO_ID);
+	glBufferData(GL_ARRAY_BUFFER, initial_vertices * sizeof(vertex), nullptr, GL_STATIC_DRAW);
+	glGenBuffers(1, &position_VBO_ID);
+	glBindBuffer(GL_ARRAY_BUFFER, position_VBO_ID);
+	glBufferData(GL_ARRAY_BUFFER, initial_vertices * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW);
+	glGenBuffers(1, &lightmap_VBO_ID);
+	glBindBuffer(GL_ARRAY_BUFFER, lightmap_VBO_ID);
+	glBufferData(GL_ARRAY_BUFFER, initial_vertices * sizeof(glm::vec2), nullptr, GL_STATIC_DRAW);
+	vertex_alloc.grow(initial_vertices);
+
+	glGenBuffers(1, &EBO_ID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO_ID);
+	glBufferData(GL_COPY_WRITE_BUFFER, initial_indices * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+	index_alloc.grow(initial_indices);
+
+	setup_attributes();
+}
+
+void GeometryPool::setup_attributes(void)
+{
+	GLState::bindVertexArray(VAO_ID);
+
+	// indices
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_ID);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO_ID);
+
+	//explain GPU the memory layout of the data...
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(0 + offsetof(vertex, position)));
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(0 + offsetof(vertex, texcoord)));
+	glEnableVertexAttribArray(1);
+
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(0 + offsetof(vertex, normal)));
+	glEnableVertexAttribArray(2);
+
+	glBindBuffer(GL_ARRAY_BUFFER, lightmap_VBO_ID);
+	glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), reinterpret_cast<void*>(0));
+	glEnableVertexAttribArray(4);
+
+	// depth-only: 12 bytes per vertex instead of 32
+	GLState::bindVertexArray(depth_VAO_ID);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_ID);
+	glBindBuffer(GL_ARRAY_BUFFER, position_VBO_ID);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(0));
+	glEnableVertexAttribArray(0);
+
+	GLState::bindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// replace buffer by a bigger one, keeping the content
+static GLuint grow_buffer(GLuint old_buffer, std::size_t old_bytes, std::size_t new_bytes)
+{
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, new_bytes, nullptr, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, old_buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_bytes);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &old_buffer);
+	return buffer;
+}
+
+void GeometryPool::grow_vertices(std::size_t min_capacity)
+{
+	std::size_t capacity = std::max(vertex_alloc.capacity() * 2, min_capacity);
+	VBO_ID = grow_buffer(VBO_ID, vertex_alloc.capacity() * sizeof(vertex), capacity * sizeof(vertex));
+	position_VBO_ID = grow_buffer(position_VBO_ID, vertex_alloc.capacity() * sizeof(glm::vec3), capacity * sizeof(glm::vec3));
+	lightmap_VBO_ID = grow_buffer(lightmap_VBO_ID, vertex_alloc.capacity() * sizeof(glm::vec2), capacity * sizeof(glm::vec2));
+	vertex_alloc.grow(capacity);
+	setup_attributes();
+}
+
+void GeometryPool::grow_indices(std::size_t min_capacity)
+{
+	std::size_t capacity = std::max(index_alloc.capacity() * 2, min_capacity);
+	EBO_ID = grow_buffer(EBO_ID, index_alloc.capacity() * sizeof(GLuint), capacity * sizeof(GLuint));
+	index_alloc.grow(capacity);
+	setup_attributes();
+}
+
+GeometryRange GeometryPool::add(const std::vector<vertex>& vertices, const std::vector<GLuint>& indices)
+{
+	if (VAO_ID == 0)
+		init();
+
+	std::size_t base_vertex = vertex_alloc.allocate(vertices.size());
+	if (base_vertex == RangeAllocator::invalid) {
+		grow_vertices(vertex_alloc.capacity() + vertices.size());
+		base_vertex = vertex_alloc.allocate(vertices.size());
+	}
+
+	std::size_t first_index = index_alloc.allocate(indices.size());
+	if (first_index == RangeAllocator::invalid) {
+		grow_indices(index_alloc.capacity() + indices.size());
+		first_index = index_alloc.allocate(indices.size());
+	}
+
+	std::vector<glm::vec3> positions(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+		positions[i] = vertices[i].position;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, VBO_ID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, base_vertex * sizeof(vertex), vertices.size() * sizeof(vertex), vertices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, position_VBO_ID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, base_vertex * sizeof(glm::vec3), positions.size() * sizeof(glm::vec3), positions.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, EBO_ID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, first_index * sizeof(GLuint), indices.size() * sizeof(GLuint), indices.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	GeometryRange range;
+	range.base_vertex = static_cast<GLint>(base_vertex);
+	range.first_index = static_cast<GLuint>(first_index);
+	range.index_count = static_cast<GLsizei>(indices.size());
+	range.vertex_count = static_cast<GLsizei>(vertices.size());
+	return range;
+}
+
+void GeometryPool::set_lightmap_uvs(const GeometryRange& range, const std::vector<glm::vec2>& uvs)
+{
+	std::size_t count = std::min(uvs.size(), static_cast<std::size_t>(range.vertex_count));
+	glBindBuffer(GL_COPY_WRITE_BUFFER, lightmap_VBO_ID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, range.base_vertex * sizeof(glm::vec2), count * sizeof(glm::vec2), uvs.data());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GeometryPool::remove(const GeometryRange& range)
+{
+	vertex_alloc.free(range.base_vertex, range.vertex_count);
+	index_alloc.free(range.first_index, range.index_count);
+}
+
+void GeometryPool::clear(void)
+{
+	if (VAO_ID == 0)
+		return;
+
+	GLState::deleteVertexArrays(1, &VAO_ID);
+	GLState::deleteVertexArrays(1, &depth_VAO_ID);
+	glDeleteBuffers(1, &VBO_ID);
+	glDeleteBuffers(1, &position_VBO_ID);
+	glDeleteBuffers(1, &lightmap_VBO_ID);
+	glDeleteBuffers(1, &EBO_ID);
+	VAO_ID = VBO_ID = EBO_ID = 0;
+	depth_VAO_ID = position_VBO_ID = lightmap_VBO_ID = 0;
+
+	vertex_alloc = RangeAllocator();
+	index_alloc = RangeAllocator();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// OpenGL Extension Wrangler
+#include <GL/glew.h>
+#include <GL/wglew.h> //WGLEW = Windows GL Extension Wrangler (change for different platform)
+
+#include <glm/glm.hpp>
+
+//vertex description
+struct vertex {
+	glm::vec3 position;
+	glm::vec2 texcoord;
+	glm::vec3 normal;
+};
+
+// Free-list sub-allocator of element ranges (first fit, neighbours are merged on free)
+class RangeAllocator {
+public:
+	static constexpr std::size_t invalid = static_cast<std::size_t>(-1);
+
+	explicit RangeAllocator(std::size_t capacity = 0) { grow(capacity); }
+
+	std::size_t allocate(std::size_t count); // returns offset or invalid
+	void free(std::size_t offset, std::size_t count);
+	void grow(std::size_t new_capacity);     // adds [capacity, new_capacity) as free
+
+	std::size_t capacity(void) const { return total; }
+	std::size_t used(void) const { return in_use; }
+
+private:
+	std::map<std::size_t, std::size_t> free_blocks; // offset -> count
+	std::size_t total = 0;
+	std::size_t in_use = 0;
+};
+
+// where a mesh lives inside the pool
+struct GeometryRange {
+	GLint base_vertex = 0;
+	GLuint first_index = 0;
+	GLsizei index_count = 0;
+	GLsizei vertex_count = 0;
+};
+
+// Geometry mega-buffer: one vertex buffer, one index buffer and one VAO for the
+// `vertex` format. Meshes register as (base vertex, first index, count) ranges and
+// draw with glDrawElementsBaseVertex, so switching meshes switches no buffers.
+// Positions are also kept in a tightly packed stream with its own VAO for
+// depth-only passes; both VAOs share the index buffer and vertex numbering.
+// Lightmap UVs are a third stream (attribute 4), filled in by the lightmap baker.
+class GeometryPool {
+public:
+	static GeometryPool& get(void); // pool of the `vertex` format
+
+	GeometryPool(const GeometryPool&) = delete;
+
+	GeometryRange add(const std::vector<vertex>& vertices, const std::vector<GLuint>& indices);
+	void remove(const GeometryRange& range);
+	// second UV set, one per vertex of the range
+	void set_lightmap_uvs(const GeometryRange& range, const std::vector<glm::vec2>& uvs);
+	void clear(void); // needs current GL context
+
+	GLuint vao(void) const { return VAO_ID; }
+	GLuint vbo(void) const { return VBO_ID; }
+	GLuint ebo(void) const { return EBO_ID; }
+	GLuint depth_vao(void) const { return depth_VAO_ID; } // position only, attribute 0
+
+	std::size_t vertex_bytes(void) const { return vertex_alloc.used() * (sizeof(vertex) + sizeof(glm::vec3) + sizeof(glm::vec2)); }
+	std::size_t index_bytes(void) const { return index_alloc.used() * sizeof(GLuint); }
+
+private:
+	GeometryPool(void) = default;
+
+	void init(void);
+	void grow_vertices(std::size_t min_capacity);
+	void grow_indices(std::size_t min_capacity);
+	void setup_attributes(void);
+
+	static constexpr std::size_t initial_vertices = 1 << 16;
+	static constexpr std::size_t initial_indices = 1 << 17;
+
+	GLuint VAO_ID = 0;
+	GLuint VBO_ID = 0;
+	GLuint EBO_ID = 0;
+	GLuint depth_VAO_ID = 0;
+	GLuint position_VBO_ID = 0;
+	GLuint lightmap_VBO_ID = 0;
+
+	RangeAllocator vertex_alloc;
+	RangeAllocator index_alloc;
+};
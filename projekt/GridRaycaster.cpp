@@ -0,0 +1,210 @@
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <limits>
+
+#include "GridRaycaster.h"
+
+void GridRaycaster::clear(void)
+{
+	boxes.clear();
+	ids.clear();
+	cell_start.clear();
+	cell_items.clear();
+	global.clear();
+	dims = glm::ivec3(0);
+}
+
+void GridRaycaster::build(const glm::vec2& origin_xz, int cols, int rows, float cell_size,
+	const std::vector<Aabb>& input_boxes, const std::vector<std::uint32_t>& input_ids)
+{
+	clear();
+	if (input_boxes.size() != input_ids.size())
+		throw std::exception("GridRaycaster: boxes and ids differ in count");
+
+	boxes = input_boxes;
+	ids = input_ids;
+	cell = cell_size;
+
+	// layers over the y range of the boxes
+	float y0 = std::numeric_limits<float>::max(), y1 = std::numeric_limits<float>::lowest();
+	for (const Aabb& b : boxes) {
+		y0 = std::min(y0, b.min.y);
+		y1 = std::max(y1, b.max.y);
+	}
+	if (boxes.empty())
+		y0 = y1 = 0.0f;
+	y0 = std::floor(y0 / cell) * cell;
+	int layers = std::max(1, static_cast<int>(std::ceil((y1 - y0) / cell)));
+	origin = glm::vec3(origin_xz.x, y0, origin_xz.y);
+	dims = glm::ivec3(cols, layers, rows);
+
+	// half-open cells like UniformGrid, a maze cube fills exactly its own cell
+	auto range = [&](const Aabb& b, glm::ivec3& c0, glm::ivec3& c1) {
+		c0 = glm::ivec3(glm::floor((b.min - origin) / cell));
+		c1 = glm::max(glm::ivec3(glm::ceil((b.max - origin) / cell)) - 1, c0);
+	};
+	auto inside = [&](const glm::ivec3& c0, const glm::ivec3& c1) {
+		return c0.x >= 0 && c0.y >= 0 && c0.z >= 0 && c1.x < dims.x && c1.y < dims.y && c1.z < dims.z;
+	};
+
+	// count, prefix sum, fill
+	const std::size_t cell_count = static_cast<std::size_t>(dims.x) * dims.y * dims.z;
+	cell_start.assign(cell_count + 1, 0);
+	std::vector<std::uint8_t> in_grid(boxes.size(), 0);
+	for (std::size_t i = 0; i < boxes.size(); ++i) {
+		glm::ivec3 c0, c1;
+		range(boxes[i], c0, c1);
+		glm::ivec3 span = c1 - c0 + 1;
+		if (!inside(c0, c1) || span.x * span.y * span.z > max_cells_per_box) {
+			global.push_back(static_cast<std::uint32_t>(i));
+			continue;
+		}
+		in_grid[i] = 1;
+		for (int z = c0.z; z <= c1.z; ++z)
+			for (int y = c0.y; y <= c1.y; ++y)
+				for (int x = c0.x; x <= c1.x; ++x)
+					cell_start[(static_cast<std::size_t>(z) * dims.y + y) * dims.x + x + 1]++;
+	}
+	for (std::size_t c = 0; c < cell_count; ++c)
+		cell_start[c + 1] += cell_start[c];
+
+	cell_items.resize(cell_start[cell_count]);
+	std::vector<std::uint32_t> fill(cell_start.begin(), cell_start.end() - 1);
+	for (std::size_t i = 0; i < boxes.size(); ++i) {
+		if (!in_grid[i])
+			continue;
+		glm::ivec3 c0, c1;
+		range(boxes[i], c0, c1);
+		for (int z = c0.z; z <= c1.z; ++z)
+			for (int y = c0.y; y <= c1.y; ++y)
+				for (int x = c0.x; x <= c1.x; ++x)
+					cell_items[fill[(static_cast<std::size_t>(z) * dims.y + y) * dims.x + x]++] = static_cast<std::uint32_t>(i);
+	}
+}
+
+bool GridRaycaster::intersect(const Aabb& box, const Ray& ray, float& distance, glm::vec3& normal)
+{
+	float t_near = -std::numeric_limits<float>::infinity();
+	float t_far = std::numeric_limits<float>::infinity();
+	int axis = -1;
+	for (int a = 0; a < 3; ++a) {
+		if (ray.direction[a] == 0.0f) {
+			if (ray.origin[a] < box.min[a] || ray.origin[a] > box.max[a])
+				return false;
+			continue;
+		}
+		float inv = 1.0f / ray.direction[a];
+		float t0 = (box.min[a] - ray.origin[a]) * inv;
+		float t1 = (box.max[a] - ray.origin[a]) * inv;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		if (t0 > t_near) {
+			t_near = t0;
+			axis = a;
+		}
+		t_far = std::min(t_far, t1);
+	}
+	if (axis < 0 || t_near > t_far || t_far < 0.0f || t_near > ray.max_distance)
+		return false;
+
+	normal = glm::vec3(0.0f);
+	if (t_near < 0.0f) {
+		distance = 0.0f;
+		return true;
+	}
+	distance = t_near;
+	normal[axis] = (ray.direction[axis] > 0.0f) ? -1.0f : 1.0f;
+	return true;
+}
+
+void GridRaycaster::test(std::uint32_t b, const Ray& ray, Hit& best, float& best_distance) const
+{
+	float distance;
+	glm::vec3 normal;
+	best.tests++;
+	if (intersect(boxes[b], ray, distance, normal) && distance < best_distance) {
+		best_distance = distance;
+		best.id = ids[b];
+		best.distance = distance;
+		best.normal = normal;
+	}
+}
+
+GridRaycaster::Hit GridRaycaster::raycast(const Ray& ray) const
+{
+	Hit best;
+	float best_distance = std::numeric_limits<float>::infinity();
+	for (std::uint32_t b : global)
+		test(b, ray, best, best_distance);
+
+	if (dims.x == 0 || dims.y == 0 || dims.z == 0)
+		return best;
+
+	// clip the ray to the grid
+	const glm::vec3 grid_max = origin + glm::vec3(dims) * cell;
+	float t_enter = 0.0f, t_exit = ray.max_distance;
+	for (int a = 0; a < 3; ++a) {
+		if (ray.direction[a] == 0.0f) {
+			if (ray.origin[a] < origin[a] || ray.origin[a] > grid_max[a])
+				return best;
+			continue;
+		}
+		float inv = 1.0f / ray.direction[a];
+		float t0 = (origin[a] - ray.origin[a]) * inv;
+		float t1 = (grid_max[a] - ray.origin[a]) * inv;
+		if (t0 > t1)
+			std::swap(t0, t1);
+		t_enter = std::max(t_enter, t0);
+		t_exit = std::min(t_exit, t1);
+	}
+	if (t_enter > t_exit || t_enter >= best_distance)
+		return best;
+
+	// DDA setup: start cell, step direction, distance to the next border and between borders per axis
+	glm::vec3 start = (ray.origin + ray.direction * t_enter - origin) / cell;
+	glm::ivec3 c = glm::clamp(glm::ivec3(glm::floor(start)), glm::ivec3(0), dims - 1);
+	glm::ivec3 step(0);
+	glm::vec3 t_next(std::numeric_limits<float>::infinity());
+	glm::vec3 t_delta(std::numeric_limits<float>::infinity());
+	for (int a = 0; a < 3; ++a) {
+		if (ray.direction[a] > 0.0f) {
+			step[a] = 1;
+			t_next[a] = (origin[a] + (c[a] + 1) * cell - ray.origin[a]) / ray.direction[a];
+			t_delta[a] = cell / ray.direction[a];
+		}
+		else if (ray.direction[a] < 0.0f) {
+			step[a] = -1;
+			t_next[a] = (origin[a] + c[a] * cell - ray.origin[a]) / ray.direction[a];
+			t_delta[a] = -cell / ray.direction[a];
+		}
+	}
+
+	for (;;) {
+		best.cells++;
+		std::size_t index = (static_cast<std::size_t>(c.z) * dims.y + c.y) * dims.x + c.x;
+		for (std::uint32_t k = cell_start[index]; k < cell_start[index + 1]; ++k)
+			test(cell_items[k], ray, best, best_distance);
+
+		// leave the cell through its nearest border
+		int a = (t_next.x < t_next.y) ? ((t_next.x < t_next.z) ? 0 : 2) : ((t_next.y < t_next.z) ? 1 : 2);
+		float cell_exit = t_next[a];
+		// nothing in a later cell can be closer than a hit before this border
+		if (best_distance <= cell_exit || cell_exit > t_exit)
+			break;
+		c[a] += step[a];
+		if (c[a] < 0 || c[a] >= dims[a])
+			break;
+		t_next[a] += t_delta[a];
+	}
+	return best;
+}
+
+void GridRaycaster::raycast(const std::vector<Ray>& rays, std::vector<Hit>& hits) const
+{
+	hits.resize(rays.size());
+	// rays are independent, the grid is read only
+	std::for_each(std::execution::par, rays.begin(), rays.end(), [&](const Ray& ray) {
+		hits[&ray - rays.data()] = raycast(ray);
+	});
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Aabb.h"
+
+// Ray queries over the static maze, walking its cells with a 3D DDA
+//
+// The grid matches the maze map in x and z (one unit per cell) and has unit
+// layers in y. Every box is registered in all cells it touches, and a ray visits
+// the cells it crosses in order (Amanatides and Woo), testing only their boxes.
+// The walk stops as soon as the closest hit so far lies before the exit of the
+// current cell. Boxes covering many cells, like the floor, sit in a short list
+// tested by every ray. A ray running exactly along a face that lies on a cell
+// border may miss that face. Built once, then read only, so any thread can cast.
+class GridRaycaster {
+public:
+	static constexpr std::uint32_t none = 0xFFFFFFFFu;
+	// boxes touching more cells than this are tested by every ray
+	static constexpr int max_cells_per_box = 8;
+
+	struct Ray {
+		glm::vec3 origin = glm::vec3(0.0f);
+		glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f); // need not be normalized, distance is in its lengths
+		float max_distance = 100.0f;
+	};
+
+	struct Hit {
+		std::uint32_t id = none;                // user id of the box, none = nothing hit
+		float distance = 0.0f;                  // 0 when the origin is inside the box
+		glm::vec3 normal = glm::vec3(0.0f);     // of the face hit, zero when inside
+		unsigned int cells = 0;                 // cells visited
+		unsigned int tests = 0;                 // boxes tested
+
+		bool hit(void) const { return id != none; }
+	};
+
+	GridRaycaster(void) = default;
+	GridRaycaster(const GridRaycaster&) = delete;
+
+	// cell (0, 0, 0) starts at origin; the layers cover the y range of the boxes
+	void build(const glm::vec2& origin_xz, int cols, int rows, float cell_size,
+		const std::vector<Aabb>& boxes, const std::vector<std::uint32_t>& ids);
+	void clear(void);
+
+	// closest hit in [0, max_distance]
+	Hit raycast(const Ray& ray) const;
+	// many rays in parallel, hits[i] for rays[i]
+	void raycast(const std::vector<Ray>& rays, std::vector<Hit>& hits) const;
+
+	// slab test of one box; false if it is missed or lies beyond max_distance
+	static bool intersect(const Aabb& box, const Ray& ray, float& distance, glm::vec3& normal);
+
+	unsigned int box_count(void) const { return static_cast<unsigned int>(boxes.size()); }
+	unsigned int global_count(void) const { return static_cast<unsigned int>(global.size()); }
+	glm::ivec3 dimensions(void) const { return dims; }
+
+private:
+	void test(std::uint32_t b, const Ray& ray, Hit& best, float& best_distance) const;
+
+	glm::vec3 origin = glm::vec3(0.0f);
+	float cell = 1.0f;
+	glm::ivec3 dims = glm::ivec3(0);
+
+	std::vector<Aabb> boxes;
+	std::vector<std::uint32_t> ids;
+	std::vector<std::uint32_t> cell_start; // dims.x * dims.y * dims.z + 1, ranges into cell_items
+	std::vector<std::uint32_t> cell_items; // indices into boxes
+	std::vector<std::uint32_t> global;     // indices into boxes
+};
@@ -9,6 +9,8 @@
 #include <stack>
 #include <random>
 #include <numeric>
+#include <algorithm>
+#include <string>
 
 // OpenCV 
 #include <opencv2\opencv.hpp>
@@ -26,13 +28,103 @@
 
 // our awesome headers
 #include "App.h"
+#include "Benchmarks.h"
 
 // define our application
 App app;
 
+// offline texture cooking: ICP.exe --cook [--raw|--bc1|--bc3] [--force] file...
+static int cook_textures(int argc, char* argv[])
+{
+	TextureCache cache;
+	TextureCompression compression = TextureCompression::automatic;
+	bool force = false;
+	int failed = 0;
+
+	for (int i = 2; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--raw")
+			compression = TextureCompression::none;
+		else if (arg == "--bc1")
+			compression = TextureCompression::bc1;
+		else if (arg == "--bc3")
+			compression = TextureCompression::bc3;
+		else if (arg == "--force")
+			force = true;
+		else {
+			try {
+				cache.cook(arg, compression, force);
+			}
+			catch (std::exception const& e) {
+				std::cerr << e.what() << std::endl;
+				failed++;
+			}
+		}
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static int usage(const char* error)
+{
+	std::cerr << error << "\n"
+		<< "usage: ICP.exe [--seed N] [--sim-hz N] [--maze N] [--maze-algorithm backtracker|wilson|eller|sidewinder]\n"
+		<< "       ICP.exe --cook [--raw|--bc1|--bc3] [--force] file...\n"
+		<< "       ICP.exe --bench-broadphase|--bench-kernels|--bench-raycast|--bench-maze [count]" << std::endl;
+	return EXIT_FAILURE;
+}
+
 // MAIN program function
-int main()
+int main(int argc, char* argv[])
 {
+	if (argc > 1 && std::string(argv[1]) == "--cook")
+		return cook_textures(argc, argv);
+
+	// numbers are parsed with std::sto*, a bad value throws
+	std::string mode = (argc > 1) ? argv[1] : "";
+	int count = 0; // 0 = default of the benchmark
+	try {
+		if (argc > 2 && mode.rfind("--bench-", 0) == 0 && (count = std::stoi(argv[2])) <= 0)
+			return usage("count must be positive");
+
+		// ICP.exe --seed N: repeatable maze, reuses its baked lightmap; --sim-hz N: simulation rate
+		// --maze N: cells per side, 2..32 in the game (larger ones only in --bench-maze); --maze-algorithm backtracker|wilson|eller|sidewinder
+		// out of range values are rejected, never clamped
+		for (int i = 1; i + 1 < argc; ++i) {
+			if (std::string(argv[i]) == "--seed")
+				app.maze_seed = static_cast<std::uint32_t>(std::stoul(argv[i + 1]));
+			else if (std::string(argv[i]) == "--sim-hz") {
+				app.sim_hz = std::stod(argv[i + 1]);
+				if (!(app.sim_hz >= 1.0))
+					return usage("sim-hz must be at least 1");
+			}
+			else if (std::string(argv[i]) == "--maze") {
+				app.maze_cells = std::stoi(argv[i + 1]);
+				if (app.maze_cells < 2 || app.maze_cells > 32)
+					return usage("maze must be 2..32 cells per side");
+			}
+			else if (std::string(argv[i]) == "--maze-algorithm")
+				app.maze_algorithm = MazeGenerator::parse(argv[i + 1]);
+		}
+	}
+	catch (std::exception const& e) {
+		return usage((std::string("bad argument: ") + e.what()).c_str());
+	}
+
+	// ICP.exe --bench-broadphase [bodies]
+	if (mode == "--bench-broadphase")
+		return bench_broadphase(count ? count : 5000);
+	// ICP.exe --bench-kernels [boxes]
+	if (mode == "--bench-kernels")
+		return bench_collision_kernels(count ? count : 4096);
+	// ICP.exe --bench-raycast [rays]
+	if (mode == "--bench-raycast")
+		return bench_raycast(count ? count : 100000);
+	// ICP.exe --bench-maze [cells per side]
+	if (mode == "--bench-maze")
+		return bench_maze(count ? count : 2048);
+	if (mode.rfind("--bench-", 0) == 0)
+		return usage(("unknown benchmark " + mode).c_str());
+
 	if (app.init())
 		return app.run();
 }
@@ -0,0 +1,146 @@
+#include <algorithm>
+
+#include "IndirectRenderer.h"
+#include "GLState.h"
+
+namespace {
+	// world space frustum planes from P*V (Gribb & Hartmann)
+	void extract_planes(const glm::mat4& pv, glm::vec4 planes[6])
+	{
+		glm::vec4 row0(pv[0][0], pv[1][0], pv[2][0], pv[3][0]);
+		glm::vec4 row1(pv[0][1], pv[1][1], pv[2][1], pv[3][1]);
+		glm::vec4 row2(pv[0][2], pv[1][2], pv[2][2], pv[3][2]);
+		glm::vec4 row3(pv[0][3], pv[1][3], pv[2][3], pv[3][3]);
+
+		planes[0] = row3 + row0; // left
+		planes[1] = row3 - row0; // right
+		planes[2] = row3 + row1; // bottom
+		planes[3] = row3 - row1; // top
+		planes[4] = row3 + row2; // near
+		planes[5] = row3 - row2; // far
+		for (int i = 0; i < 6; ++i)
+			planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+void IndirectRenderer::init(void)
+{
+	cull_shader = ShaderProgram("resources/shaders/cull.comp");
+	draw_shader = ShaderProgram("resources/shaders/obj.vert", "resources/shaders/obj.frag");
+
+	glGenBuffers(1, &instance_buffer);
+	glGenBuffers(1, &command_buffer);
+}
+
+void IndirectRenderer::build(const std::vector<Mesh*>& scene_meshes)
+{
+	// everything else is per object data, only the 2D texture binding splits draws
+	std::vector<Mesh*> meshes = scene_meshes;
+	std::stable_sort(meshes.begin(), meshes.end(), [](const Mesh* a, const Mesh* b) {
+		return std::tie(a->texture, a->primitive) < std::tie(b->texture, b->primitive);
+	});
+
+	groups.clear();
+	instances.resize(meshes.size());
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		const Mesh* m = meshes[i];
+		if (groups.empty() || groups.back().mesh->texture != m->texture || groups.back().mesh->primitive != m->primitive)
+			groups.push_back(Group{ m, static_cast<GLuint>(i), 0 });
+		groups.back().count++;
+
+		instances[i].sphere = m->calculateBoundingSphere();
+		instances[i].index_count = static_cast<GLuint>(m->geometry.index_count);
+		instances[i].first_index = m->geometry.first_index;
+		instances[i].base_vertex = m->geometry.base_vertex;
+		instances[i].object_index = m->object_index;
+	}
+
+	// instances never change, moving objects only update their ObjectBuffer entry
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, instance_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(GpuInstance), instances.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, command_buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void IndirectRenderer::cull(const glm::mat4& projection_matrix, const glm::mat4& view_matrix)
+{
+	if (instances.empty())
+		return;
+
+	// objects are already bound at ObjectBuffer::binding
+	glm::vec4 planes[6];
+	extract_planes(projection_matrix * view_matrix, planes);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, command_buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, instance_buffer);
+
+	cull_shader.activate();
+	for (int i = 0; i < 6; ++i)
+		cull_shader.setUniform("frustumPlanes[" + std::to_string(i) + "]", planes[i]);
+	cull_shader.setUniform("instanceCount", static_cast<unsigned int>(instances.size()));
+	glDispatchCompute((static_cast<GLuint>(instances.size()) + 63) / 64, 1, 1);
+
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void IndirectRenderer::draw_depth(void)
+{
+	if (instances.empty())
+		return;
+
+	// no texture binds, groups only split by primitive
+	GLState::bindVertexArray(GeometryPool::get().depth_vao());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	for (size_t i = 0; i < groups.size(); ) {
+		size_t last = i;
+		while (last + 1 < groups.size() && groups[last + 1].mesh->primitive == groups[i].mesh->primitive)
+			++last;
+
+		GLsizei count = static_cast<GLsizei>(groups[last].first + groups[last].count - groups[i].first);
+		glMultiDrawElementsIndirect(groups[i].mesh->primitive, GL_UNSIGNED_INT,
+			reinterpret_cast<void*>(static_cast<std::size_t>(groups[i].first) * sizeof(DrawElementsIndirectCommand)),
+			count, 0);
+		i = last + 1;
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectRenderer::draw(const glm::mat4& projection_matrix, const glm::mat4& view_matrix, const glm::vec3& viewPos, const glm::vec3& flashLightPosition, const glm::vec3& flashLightDirection)
+{
+	if (instances.empty())
+		return;
+
+	// one multi-draw per texture
+	Mesh::setFrameUniforms(draw_shader, projection_matrix, view_matrix, viewPos, flashLightPosition, flashLightDirection);
+	GLState::bindVertexArray(GeometryPool::get().vao());
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+	for (auto const& g : groups) {
+		GLState::activeTexture(GL_TEXTURE0);
+		if (g.mesh->texture != 0)
+			GLState::bindTexture(GL_TEXTURE_2D, g.mesh->texture);
+
+		glMultiDrawElementsIndirect(g.mesh->primitive, GL_UNSIGNED_INT,
+			reinterpret_cast<void*>(static_cast<std::size_t>(g.first) * sizeof(DrawElementsIndirectCommand)),
+			g.count, 0);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void IndirectRenderer::clear(void)
+{
+	if (instance_buffer == 0)
+		return; // init() never called
+
+	cull_shader.clear();
+	draw_shader.clear();
+
+	glDeleteBuffers(1, &instance_buffer);
+	glDeleteBuffers(1, &command_buffer);
+	instance_buffer = command_buffer = 0;
+
+	instances.clear();
+	groups.clear();
+}
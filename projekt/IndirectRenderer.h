@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+
+#include "Mesh.h"
+#include "ShaderProgram.h"
+
+// GPU-driven path: frustum culling in a compute shader + multi-draw-indirect
+//
+// All opaque instances and their bounding spheres live in an SSBO, transforms and
+// materials come from the ObjectBuffer. Each frame cull.comp writes one
+// DrawElementsIndirectCommand per instance (instanceCount 0 when culled) and every
+// group of instances sharing a 2D texture is submitted with a single
+// glMultiDrawElementsIndirect over the GeometryPool buffers.
+class IndirectRenderer {
+public:
+	IndirectRenderer(void) = default;
+	IndirectRenderer(const IndirectRenderer&) = delete;
+
+	void init(void); // needs GL context
+	// static layout of the scene; meshes must be registered in the ObjectBuffer
+	void build(const std::vector<Mesh*>& meshes);
+	// fill the command buffer for this view, once per frame before any draw
+	void cull(const glm::mat4& projection_matrix, const glm::mat4& view_matrix);
+	// position-only draw of the culled instances, depth program must be active
+	void draw_depth(void);
+	void draw(const glm::mat4& projection_matrix, const glm::mat4& view_matrix, const glm::vec3& viewPos, const glm::vec3& flashLightPosition, const glm::vec3& flashLightDirection);
+	void clear(void);
+
+	unsigned int instance_count(void) const { return static_cast<unsigned int>(instances.size()); }
+	unsigned int group_count(void) const { return static_cast<unsigned int>(groups.size()); }
+
+private:
+	// std430 layout, must match cull.comp
+	struct GpuInstance {
+		glm::vec4 sphere; // local space
+		GLuint index_count;
+		GLuint first_index;
+		GLint base_vertex;
+		GLuint object_index;
+	};
+
+	struct DrawElementsIndirectCommand {
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint base_vertex;
+		GLuint base_instance;
+	};
+
+	// instances sharing all draw state, consecutive in the instance array
+	struct Group {
+		const Mesh* mesh; // representative for texture and primitive
+		GLuint first;
+		GLuint count;
+	};
+
+	ShaderProgram cull_shader;
+	ShaderProgram draw_shader;
+
+	GLuint instance_buffer = 0;
+	GLuint command_buffer = 0;
+
+	std::vector<GpuInstance> instances;
+	std::vector<Group> groups;
+};
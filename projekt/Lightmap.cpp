@@ -0,0 +1,538 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <execution>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "Lightmap.h"
+#include "GLState.h"
+
+static constexpr char lmap_magic[4] = { 'L', 'M', 'A', 'P' };
+static constexpr std::uint32_t lmap_version = 2;
+
+#pragma pack(push, 1)
+struct LmapHeader {
+	char magic[4];              // "LMAP"
+	std::uint32_t version;
+	std::uint32_t seed;         // maze seed
+	std::uint64_t hash;         // geometry, lights and settings
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t pages;
+	// followed by pages * width * height RGB half floats
+};
+#pragma pack(pop)
+
+namespace {
+	// FNV-1a over raw bytes
+	void hash_bytes(std::uint64_t& hash, const void* data, std::size_t size)
+	{
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		for (std::size_t i = 0; i < size; ++i) {
+			hash ^= p[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	template <typename T>
+	void hash_value(std::uint64_t& hash, const T& value)
+	{
+		hash_bytes(hash, &value, sizeof(value));
+	}
+
+	float cross2(const glm::vec2& a, const glm::vec2& b)
+	{
+		return a.x * b.y - a.y * b.x;
+	}
+
+	float segment_distance(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b)
+	{
+		glm::vec2 ab = b - a;
+		float t = glm::clamp(glm::dot(p - a, ab) / std::max(glm::dot(ab, ab), 1e-12f), 0.0f, 1.0f);
+		return glm::length(p - (a + ab * t));
+	}
+
+	float max_scale(const glm::mat4& m)
+	{
+		return glm::max(glm::length(glm::vec3(m[0])), glm::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+	}
+
+	// vertex index of corner k of triangle t, meshes without indices are plain triangle lists
+	GLuint corner(const Mesh& mesh, std::size_t t, int k)
+	{
+		return mesh.indices.empty() ? static_cast<GLuint>(3 * t + k) : mesh.indices[3 * t + k];
+	}
+
+	std::size_t triangle_count(const Mesh& mesh)
+	{
+		return (mesh.indices.empty() ? mesh.vertices.size() : mesh.indices.size()) / 3;
+	}
+}
+
+Lightmap::Chart Lightmap::make_chart(const Mesh& mesh, const LightmapSettings& settings) const
+{
+	std::size_t triangles = triangle_count(mesh);
+	float scale = max_scale(mesh.model_matrix);
+
+	std::vector<glm::vec3> p(3 * triangles);
+	for (std::size_t t = 0; t < triangles; ++t)
+		for (int k = 0; k < 3; ++k)
+			p[3 * t + k] = mesh.vertices[corner(mesh, t, k)].position * scale;
+
+	// a triangle shares its cell with the next one when both form a flat quad, as models export them
+	auto same_quad = [&](std::size_t t, std::size_t u) {
+		glm::vec3 nt = glm::cross(p[3 * t + 1] - p[3 * t], p[3 * t + 2] - p[3 * t]);
+		glm::vec3 nu = glm::cross(p[3 * u + 1] - p[3 * u], p[3 * u + 2] - p[3 * u]);
+		if (glm::length(nt) < 1e-12f || glm::length(nu) < 1e-12f || glm::dot(glm::normalize(nt), glm::normalize(nu)) < 0.999f)
+			return false;
+		int shared = 0;
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				shared += glm::length(p[3 * t + i] - p[3 * u + j]) < 1e-5f;
+		return shared == 2;
+	};
+	std::vector<std::size_t> cell_of(triangles);
+	std::size_t cell_count = 0;
+	for (std::size_t t = 0; t < triangles; ++t) {
+		cell_of[t] = cell_count++;
+		if (t + 1 < triangles && same_quad(t, t + 1)) {
+			cell_of[t + 1] = cell_of[t];
+			++t;
+		}
+	}
+
+	// laid flat in the plane of the cell's first triangle, world units, origin at the cell's bounding box corner
+	std::vector<glm::vec2> flat(3 * triangles, glm::vec2(0.0f));
+	float extent = 1e-3f;
+	for (std::size_t t = 0; t < triangles; ) {
+		std::size_t end = t + 1;
+		while (end < triangles && cell_of[end] == cell_of[t])
+			++end;
+
+		glm::vec3 n = glm::cross(p[3 * t + 1] - p[3 * t], p[3 * t + 2] - p[3 * t]);
+		if (glm::length(n) < 1e-12f) {
+			t = end;
+			continue; // degenerate, stays in the cell corner
+		}
+		glm::vec3 e0 = glm::normalize(p[3 * t + 1] - p[3 * t]);
+		glm::vec3 e1 = glm::cross(glm::normalize(n), e0);
+
+		glm::vec2 lo(1e30f);
+		for (std::size_t c = 3 * t; c < 3 * end; ++c) {
+			flat[c] = glm::vec2(glm::dot(p[c] - p[3 * t], e0), glm::dot(p[c] - p[3 * t], e1));
+			lo = glm::min(lo, flat[c]);
+		}
+		for (std::size_t c = 3 * t; c < 3 * end; ++c) {
+			flat[c] -= lo;
+			extent = std::max(extent, std::max(flat[c].x, flat[c].y));
+		}
+		t = end;
+	}
+
+	// grid of equal cells, shrink the density if the block would not fit a page
+	int columns = std::max(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(cell_count)))), 1);
+	int rows = std::max(static_cast<int>((cell_count + columns - 1) / columns), 1);
+	float density = settings.texels_per_unit;
+	int cell = static_cast<int>(std::ceil(extent * density)) + 2 * settings.padding + 1;
+	if (std::max(columns, rows) * cell > settings.max_atlas_size) {
+		cell = settings.max_atlas_size / std::max(columns, rows);
+		density = std::max(cell - 2 * settings.padding - 1, 1) / extent;
+	}
+
+	Chart chart;
+	chart.width = columns * cell;
+	chart.height = rows * cell;
+	const glm::vec2 block(static_cast<float>(chart.width), static_cast<float>(chart.height));
+	chart.uvs.assign(mesh.vertices.size(), glm::vec2(0.0f));
+	for (std::size_t t = 0; t < triangles; ++t) {
+		glm::vec2 origin(static_cast<float>((cell_of[t] % columns) * cell + settings.padding), static_cast<float>((cell_of[t] / columns) * cell + settings.padding));
+		for (int k = 0; k < 3; ++k)
+			chart.uvs[corner(mesh, t, k)] = (origin + flat[3 * t + k] * density) / block;
+	}
+	return chart;
+}
+
+void Lightmap::pack(std::vector<Placement>& placements, int width, int page_height)
+{
+	// shelves, tallest blocks first; a full page continues on the next one
+	std::stable_sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b) {
+		return a.chart->height > b.chart->height;
+	});
+
+	int x = 0, y = 0, shelf = 0, page = 0;
+	atlas_height = 1;
+	for (Placement& p : placements) {
+		if (x + p.chart->width > width) {
+			x = 0;
+			y += shelf;
+			shelf = 0;
+		}
+		if (y + p.chart->height > page_height) {
+			x = y = shelf = 0;
+			++page;
+		}
+		p.x = x;
+		p.y = y;
+		p.page = page;
+		x += p.chart->width;
+		shelf = std::max(shelf, p.chart->height);
+		atlas_height = std::max(atlas_height, y + shelf);
+	}
+
+	atlas_width = width;
+	atlas_pages = page + 1;
+}
+
+glm::vec3 Lightmap::direct(const glm::vec3& position, const glm::vec3& normal, const std::vector<PointLight>& lights) const
+{
+	// same terms as obj.frag without specular, albedo is applied at runtime
+	const AmbientLight ambient;
+	const DirectionalLight sun;
+	const float bias = 1e-3f;
+	glm::vec3 origin = position + normal * bias;
+
+	glm::vec3 irradiance = ambient.ambient + ambient.diffuse + sun.ambient;
+
+	glm::vec3 to_sun = glm::normalize(-sun.direction);
+	float ndl = glm::dot(normal, to_sun);
+	if (ndl > 0.0f && !bvh.occluded(origin, to_sun, 1e30f))
+		irradiance += sun.diffuse * ndl;
+
+	for (const PointLight& light : lights) {
+		if (!light.baked)
+			continue;
+
+		glm::vec3 to_light = light.position - position;
+		float distance = glm::length(to_light);
+		if (distance >= light.radius || distance < 1e-6f)
+			continue;
+		glm::vec3 dir = to_light / distance;
+
+		float window = glm::clamp(1.0f - std::pow(distance / light.radius, 4.0f), 0.0f, 1.0f);
+		float attenuation = window * window / (1.0f + 0.045f * distance + 0.0075f * distance * distance);
+		glm::vec3 color = light.color * light.intensity;
+
+		irradiance += color * light.ambient * attenuation;
+		ndl = glm::dot(normal, dir);
+		if (ndl > 0.0f && !bvh.occluded(origin, dir, distance - bias))
+			irradiance += color * ndl * attenuation;
+	}
+	return irradiance;
+}
+
+void Lightmap::bake(const std::vector<Placement>& placements, const std::vector<PointLight>& lights, const LightmapSettings& settings)
+{
+	// all static triangles in world space
+	std::vector<glm::vec3> world;
+	triangle_normals.clear();
+	for (const Placement& p : placements) {
+		const Mesh& mesh = *p.mesh;
+		for (std::size_t t = 0; t < triangle_count(mesh); ++t) {
+			glm::vec3 v[3];
+			for (int k = 0; k < 3; ++k) {
+				v[k] = glm::vec3(mesh.model_matrix * glm::vec4(mesh.vertices[corner(mesh, t, k)].position, 1.0f));
+				world.push_back(v[k]);
+			}
+			glm::vec3 n = glm::cross(v[1] - v[0], v[2] - v[0]);
+			triangle_normals.push_back(glm::length(n) > 0.0f ? glm::normalize(n) : glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+	}
+	bvh.build(world);
+
+	std::vector<glm::vec3> radiance(static_cast<std::size_t>(atlas_width) * atlas_height * atlas_pages, glm::vec3(0.0f));
+	std::vector<std::uint8_t> coverage(radiance.size(), 0); // 0 empty, 1 dilated, 2 inside
+
+	// blocks never overlap, each object is baked by one worker
+	std::for_each(std::execution::par, placements.begin(), placements.end(), [&](const Placement& p) {
+		const Mesh& mesh = *p.mesh;
+		glm::mat3 normal_matrix = glm::inverseTranspose(glm::mat3(mesh.model_matrix));
+		glm::vec2 block_origin(static_cast<float>(p.x), static_cast<float>(p.y));
+		glm::vec2 block(static_cast<float>(p.chart->width), static_cast<float>(p.chart->height));
+		std::size_t page_offset = static_cast<std::size_t>(p.page) * atlas_width * atlas_height;
+
+		for (std::size_t t = 0; t < triangle_count(mesh); ++t) {
+			glm::vec2 c[3];
+			glm::vec3 pos[3], nrm[3];
+			for (int k = 0; k < 3; ++k) {
+				const vertex& v = mesh.vertices[corner(mesh, t, k)];
+				c[k] = block_origin + p.chart->uvs[corner(mesh, t, k)] * block;
+				pos[k] = glm::vec3(mesh.model_matrix * glm::vec4(v.position, 1.0f));
+				nrm[k] = normal_matrix * v.normal;
+			}
+			float area = cross2(c[1] - c[0], c[2] - c[0]);
+			if (std::abs(area) < 1e-8f)
+				continue;
+
+			int x0 = std::max(static_cast<int>(std::floor(std::min({ c[0].x, c[1].x, c[2].x }))) - settings.padding, p.x);
+			int y0 = std::max(static_cast<int>(std::floor(std::min({ c[0].y, c[1].y, c[2].y }))) - settings.padding, p.y);
+			int x1 = std::min(static_cast<int>(std::ceil(std::max({ c[0].x, c[1].x, c[2].x }))) + settings.padding, p.x + p.chart->width - 1);
+			int y1 = std::min(static_cast<int>(std::ceil(std::max({ c[0].y, c[1].y, c[2].y }))) + settings.padding, p.y + p.chart->height - 1);
+
+			for (int ty = y0; ty <= y1; ++ty) {
+				for (int tx = x0; tx <= x1; ++tx) {
+					std::size_t index = page_offset + static_cast<std::size_t>(ty) * atlas_width + tx;
+					glm::vec2 center(tx + 0.5f, ty + 0.5f);
+					glm::vec3 bary(cross2(c[2] - c[1], center - c[1]), cross2(c[0] - c[2], center - c[2]), cross2(c[1] - c[0], center - c[0]));
+					bary /= area;
+
+					bool inside = bary.x >= 0.0f && bary.y >= 0.0f && bary.z >= 0.0f;
+					if (!inside) {
+						// dilate into the padding so bilinear filtering never reads empty texels
+						if (coverage[index] != 0)
+							continue;
+						float distance = std::min({ segment_distance(center, c[0], c[1]), segment_distance(center, c[1], c[2]), segment_distance(center, c[2], c[0]) });
+						if (distance > settings.padding)
+							continue;
+						bary = glm::max(bary, glm::vec3(0.0f));
+						bary /= bary.x + bary.y + bary.z;
+					}
+
+					glm::vec3 position = bary.x * pos[0] + bary.y * pos[1] + bary.z * pos[2];
+					glm::vec3 normal = glm::normalize(bary.x * nrm[0] + bary.y * nrm[1] + bary.z * nrm[2]);
+					glm::vec3 irradiance = direct(position, normal, lights);
+
+					// one diffuse bounce, cosine weighted hemisphere
+					if (settings.bounce_samples > 0) {
+						std::minstd_rand rng(static_cast<std::uint32_t>(index * 2654435761u + 1));
+						std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+						glm::vec3 helper = std::abs(normal.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+						glm::vec3 tangent = glm::normalize(glm::cross(helper, normal));
+						glm::vec3 bitangent = glm::cross(normal, tangent);
+
+						glm::vec3 gathered(0.0f);
+						for (int s = 0; s < settings.bounce_samples; ++s) {
+							float u1 = uniform(rng), u2 = uniform(rng);
+							float r = std::sqrt(u1), phi = 6.2831853f * u2;
+							glm::vec3 dir = tangent * (r * std::cos(phi)) + bitangent * (r * std::sin(phi)) + normal * std::sqrt(1.0f - u1);
+
+							float hit_t;
+							std::uint32_t hit;
+							if (!bvh.intersect(position + normal * 1e-3f, dir, 1e30f, hit_t, hit))
+								continue; // sky, covered by the constant ambient term
+							glm::vec3 hit_normal = triangle_normals[hit];
+							if (glm::dot(hit_normal, dir) > 0.0f)
+								hit_normal = -hit_normal;
+							gathered += direct(position + normal * 1e-3f + dir * hit_t, hit_normal, lights);
+						}
+						irradiance += settings.bounce_albedo * gathered / static_cast<float>(settings.bounce_samples);
+					}
+
+					radiance[index] = irradiance;
+					coverage[index] = inside ? 2 : 1;
+				}
+			}
+		}
+	});
+
+	texels.resize(radiance.size() * 3);
+	for (std::size_t i = 0; i < radiance.size(); ++i)
+		for (int k = 0; k < 3; ++k)
+			texels[3 * i + k] = glm::packHalf1x16(radiance[i][k]);
+}
+
+std::filesystem::path Lightmap::cache_path(std::uint32_t seed) const
+{
+	return cache_dir / (std::to_string(seed) + ".lmap");
+}
+
+bool Lightmap::load_cache(std::uint32_t seed, std::uint64_t hash)
+{
+	std::ifstream in(cache_path(seed), std::ios::binary);
+	if (!in)
+		return false;
+
+	LmapHeader hdr;
+	if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)))
+		return false;
+	if (std::memcmp(hdr.magic, lmap_magic, 4) != 0 || hdr.version != lmap_version || hdr.seed != seed || hdr.hash != hash ||
+		static_cast<int>(hdr.width) != atlas_width || static_cast<int>(hdr.height) != atlas_height || static_cast<int>(hdr.pages) != atlas_pages)
+		return false;
+
+	texels.resize(static_cast<std::size_t>(atlas_width) * atlas_height * atlas_pages * 3);
+	return static_cast<bool>(in.read(reinterpret_cast<char*>(texels.data()), texels.size() * sizeof(std::uint16_t)));
+}
+
+void Lightmap::save_cache(std::uint32_t seed, std::uint64_t hash) const
+{
+	LmapHeader hdr{};
+	std::memcpy(hdr.magic, lmap_magic, 4);
+	hdr.version = lmap_version;
+	hdr.seed = seed;
+	hdr.hash = hash;
+	hdr.width = atlas_width;
+	hdr.height = atlas_height;
+	hdr.pages = atlas_pages;
+
+	auto path = cache_path(seed);
+	std::filesystem::create_directories(path.parent_path());
+	// write to temp file first, an interrupted bake never leaves a valid-looking cache
+	auto temp = path;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			std::cout << "Can not write lightmap cache: " << temp.string() << std::endl;
+			return;
+		}
+		out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+		out.write(reinterpret_cast<const char*>(texels.data()), texels.size() * sizeof(std::uint16_t));
+	}
+	std::filesystem::rename(temp, path);
+}
+
+void Lightmap::upload(void)
+{
+	if (texture == 0)
+		glGenTextures(1, &texture);
+
+	GLState::activeTexture(GL_TEXTURE2);
+	GLState::bindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB16F, atlas_width, atlas_height, atlas_pages, 0, GL_RGB, GL_HALF_FLOAT, texels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	GLState::activeTexture(GL_TEXTURE0);
+}
+
+void Lightmap::build(const std::vector<Mesh*>& meshes, const std::vector<PointLight>& lights, std::uint32_t seed, const LightmapSettings& settings)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// the atlas has to fit the GPU
+	LightmapSettings fitted = settings;
+	GLint gl_max_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &gl_max_size);
+	if (gl_max_size > 0)
+		fitted.max_atlas_size = std::min(fitted.max_atlas_size, static_cast<int>(gl_max_size));
+
+	// second UV set, generated once per distinct geometry; lower density until all blocks fit one page,
+	// at the lowest density spill over to more pages
+	std::map<GLint, Chart> charts;
+	std::vector<Placement> placements;
+	bool fits = false;
+	for (;;) {
+		charts.clear();
+		placements.clear();
+		double area = 0.0;
+		int largest = 1;
+		for (Mesh* mesh : meshes) {
+			auto it = charts.find(mesh->geometry.base_vertex);
+			if (it == charts.end())
+				it = charts.emplace(mesh->geometry.base_vertex, make_chart(*mesh, fitted)).first;
+			placements.push_back(Placement{ mesh, &it->second, 0, 0, 0 });
+			area += static_cast<double>(it->second.width) * it->second.height;
+			largest = std::max({ largest, it->second.width, it->second.height });
+		}
+
+		// smallest power of two width for the total area, wider while the shelves come out taller than wide
+		int width = 64;
+		while (width < largest || static_cast<double>(width) * width < area)
+			width *= 2;
+		width = std::min(width, fitted.max_atlas_size);
+		for (;;) {
+			pack(placements, width, fitted.max_atlas_size);
+			if ((atlas_pages == 1 && atlas_height <= width) || width >= fitted.max_atlas_size)
+				break;
+			width = std::min(width * 2, fitted.max_atlas_size);
+		}
+
+		bool lowest = fitted.texels_per_unit * 0.75f < fitted.min_texels_per_unit;
+		if (atlas_pages == 1 || (lowest && atlas_pages <= fitted.max_atlas_pages)) {
+			fits = true;
+			break;
+		}
+		if (lowest)
+			break;
+		fitted.texels_per_unit *= 0.75f;
+	}
+
+	// too big to bake: no lightmap, the shader lights these surfaces per pixel like moving objects
+	if (!fits) {
+		std::cout << "Lightmap: " << meshes.size() << " objects need " << atlas_pages << " pages of " << fitted.max_atlas_size << 'x' << fitted.max_atlas_size
+			<< " at " << fitted.texels_per_unit << " texels per unit (max " << fitted.max_atlas_pages << "), static lighting is computed per pixel" << std::endl;
+		for (Mesh* mesh : meshes) {
+			mesh->lightmap_rect = glm::vec4(0.0f);
+			mesh->lightmap_layer = 0;
+		}
+		clear();
+		atlas_width = atlas_height = atlas_pages = 0;
+		cached = false;
+		bake_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return;
+	}
+	for (Mesh* mesh : meshes)
+		GeometryPool::get().set_lightmap_uvs(mesh->geometry, charts.at(mesh->geometry.base_vertex).uvs);
+
+	// everything the result depends on
+	std::uint64_t hash = 14695981039346656037ull;
+	hash_value(hash, fitted.texels_per_unit);
+	hash_value(hash, fitted.max_atlas_size);
+	hash_value(hash, fitted.max_atlas_pages);
+	hash_value(hash, settings.padding);
+	hash_value(hash, settings.bounce_samples);
+	hash_value(hash, settings.bounce_albedo);
+	for (const Placement& p : placements) {
+		hash_value(hash, p.mesh->model_matrix);
+		hash_value(hash, p.mesh->geometry.vertex_count);
+		hash_value(hash, p.mesh->geometry.index_count);
+	}
+	// geometry itself once per distinct mesh, an edited model with the same counts must rebake
+	for (const auto& [base_vertex, chart] : charts) {
+		const Mesh& mesh = *std::find_if(placements.begin(), placements.end(), [&](const Placement& p) { return p.chart == &chart; })->mesh;
+		for (const vertex& v : mesh.vertices) {
+			hash_value(hash, v.position);
+			hash_value(hash, v.normal);
+		}
+		if (!mesh.indices.empty())
+			hash_bytes(hash, mesh.indices.data(), mesh.indices.size() * sizeof(mesh.indices[0]));
+	}
+	for (const PointLight& light : lights) {
+		if (!light.baked)
+			continue;
+		hash_value(hash, light.position);
+		hash_value(hash, light.color * light.intensity);
+		hash_value(hash, light.ambient);
+		hash_value(hash, light.radius);
+	}
+	const DirectionalLight sun;
+	const AmbientLight ambient;
+	hash_value(hash, sun);
+	hash_value(hash, ambient);
+
+	cached = load_cache(seed, hash);
+	if (!cached) {
+		bake(placements, lights, fitted);
+		save_cache(seed, hash);
+	}
+
+	for (const Placement& p : placements) {
+		p.mesh->lightmap_rect = glm::vec4(
+			static_cast<float>(p.chart->width) / atlas_width, static_cast<float>(p.chart->height) / atlas_height,
+			static_cast<float>(p.x) / atlas_width, static_cast<float>(p.y) / atlas_height);
+		p.mesh->lightmap_layer = p.page;
+	}
+
+	upload();
+
+	bake_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Lightmap " << atlas_width << 'x' << atlas_height << 'x' << atlas_pages << " for " << placements.size() << " objects, "
+		<< fitted.texels_per_unit << " texels per unit, " << (cached ? "loaded from cache" : "baked") << " in " << bake_time << " s" << std::endl;
+}
+
+void Lightmap::clear(void)
+{
+	if (texture != 0)
+		GLState::deleteTextures(1, &texture);
+	texture = 0;
+	texels.clear();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// OpenGL Extension Wrangler
+#include <GL/glew.h>
+#include <GL/wglew.h> //WGLEW = Windows GL Extension Wrangler (change for different platform)
+
+#include <glm/glm.hpp>
+
+#include "Lights.h"
+#include "Mesh.h"
+#include "TriangleBvh.h"
+
+struct LightmapSettings {
+	float texels_per_unit = 16.0f;    // lowered until all blocks fit one page
+	float min_texels_per_unit = 2.0f; // lowest density, more pages only here
+	int max_atlas_size = 2048;        // per side of a page, also limited by GL_MAX_TEXTURE_SIZE
+	int max_atlas_pages = 4;          // layers of the atlas array
+	int padding = 2;            // texels of dilation around each triangle
+	int bounce_samples = 16;    // rays per texel for one indirect bounce, 0 = direct only
+	float bounce_albedo = 0.5f; // surfaces are untextured for the bounce
+};
+
+// Baked static lighting for static geometry
+//
+// Every mesh gets a second UV set at bake time: one square cell per triangle, or
+// per quad when two neighbouring triangles are coplanar, laid flat at a uniform
+// texel density. Instances of a mesh share the UVs and each gets its own block
+// in the atlas (Mesh::lightmap_rect, Mesh::lightmap_layer). Ambient, sun and
+// baked point lights, with shadows and optionally one diffuse bounce, are ray
+// traced on the CPU against a BVH of all static triangles, in parallel. The
+// result is cached on disk keyed by the maze seed and a hash of all inputs.
+// The atlas is an array of pages up to max_atlas_size: the density is lowered
+// until the blocks fit one page, at the lowest density up to max_atlas_pages are
+// used. A scene that still does not fit is not baked and is lit per pixel.
+class Lightmap {
+public:
+	explicit Lightmap(const std::filesystem::path& cache_dir = "cache/lightmaps") : cache_dir(cache_dir) {}
+	Lightmap(const Lightmap&) = delete;
+
+	// bake or load from cache, sets lightmap_rect and lightmap_layer of the meshes, uploads UVs and the atlas
+	void build(const std::vector<Mesh*>& meshes, const std::vector<PointLight>& lights, std::uint32_t seed, const LightmapSettings& settings = {});
+	void clear(void); // needs current GL context
+
+	GLuint id(void) const { return texture; }
+	int width(void) const { return atlas_width; }
+	int height(void) const { return atlas_height; }
+	int pages(void) const { return atlas_pages; }
+	bool baked(void) const { return texture != 0; } // false: the scene did not fit, lit per pixel
+	bool from_cache(void) const { return cached; }
+	double bake_seconds(void) const { return bake_time; }
+
+private:
+	// UV layout of one mesh, shared by its instances
+	struct Chart {
+		std::vector<glm::vec2> uvs; // per vertex, 0..1 inside the block
+		int width = 0;              // block size in texels
+		int height = 0;
+	};
+	struct Placement {
+		Mesh* mesh;
+		const Chart* chart;
+		int x, y;                   // block origin in its page
+		int page;
+	};
+
+	Chart make_chart(const Mesh& mesh, const LightmapSettings& settings) const;
+	void pack(std::vector<Placement>& placements, int width, int page_height);
+	void bake(const std::vector<Placement>& placements, const std::vector<PointLight>& lights, const LightmapSettings& settings);
+	glm::vec3 direct(const glm::vec3& position, const glm::vec3& normal, const std::vector<PointLight>& lights) const;
+
+	std::filesystem::path cache_path(std::uint32_t seed) const;
+	bool load_cache(std::uint32_t seed, std::uint64_t hash);
+	void save_cache(std::uint32_t seed, std::uint64_t hash) const;
+	void upload(void);
+
+	std::filesystem::path cache_dir;
+	TriangleBvh bvh;
+	std::vector<glm::vec3> triangle_normals;
+
+	int atlas_width = 0;
+	int atlas_height = 0;
+	int atlas_pages = 0;
+	std::vector<std::uint16_t> texels; // RGB half floats, pages one after another
+	GLuint texture = 0;
+	bool cached = false;
+	double bake_time = 0.0;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Light descriptions shared by the obj.frag uniforms, ClusteredLights and the lightmap baker
+
+// point light with finite range, world space
+struct PointLight {
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 color = glm::vec3(1.0f);   // diffuse and specular
+	float ambient = 0.1f;                // ambient = color * ambient
+	float radius = 5.0f;                 // no contribution beyond
+	float intensity = 1.0f;              // animated, multiplies color
+	bool baked = false;                  // static, in lightmaps; skipped on lightmapped surfaces
+};
+
+// sun, world space direction
+struct DirectionalLight {
+	glm::vec3 direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+	glm::vec3 ambient = glm::vec3(0.1f);
+	glm::vec3 diffuse = glm::vec3(0.2f);
+	glm::vec3 specular = glm::vec3(0.3f);
+};
+
+// comes from every direction
+struct AmbientLight {
+	glm::vec3 ambient = glm::vec3(0.05f);
+	glm::vec3 diffuse = glm::vec3(0.05f);
+	glm::vec3 specular = glm::vec3(0.05f);
+};
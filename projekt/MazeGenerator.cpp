@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <random>
+
+#include "MazeGenerator.h"
+
+static const int step_x[4] = { 1, 0, -1, 0 };
+static const int step_y[4] = { 0, -1, 0, 1 };
+
+// uniform in [0, n), the same everywhere (std::uniform_int_distribution is not)
+static std::uint32_t below(std::mt19937& rng, std::uint32_t n)
+{
+	return static_cast<std::uint32_t>((static_cast<std::uint64_t>(rng()) * n) >> 32);
+}
+
+Maze::Maze(int width, int height)
+{
+	if (width < 1 || height < 1 || static_cast<std::uint64_t>(width) * height > 0x80000000ull)
+		throw std::exception("Maze: size out of range");
+	w = width;
+	h = height;
+	row_bytes = (static_cast<std::size_t>(w) + 3) / 4;
+	bits.assign(row_bytes * h, 0);
+}
+
+bool Maze::open(int x, int y, Direction d) const
+{
+	switch (d) {
+	case east:
+		return x + 1 < w && (bits[y * row_bytes + x / 4] >> ((x & 3) * 2)) & 1;
+	case north:
+		return y > 0 && (bits[y * row_bytes + x / 4] >> ((x & 3) * 2 + 1)) & 1;
+	case west:
+		return x > 0 && open(x - 1, y, east);
+	default:
+		return y + 1 < h && open(x, y + 1, north);
+	}
+}
+
+void Maze::carve(int x, int y, Direction d)
+{
+	switch (d) {
+	case east:
+		bits[y * row_bytes + x / 4] |= static_cast<std::uint8_t>(1 << ((x & 3) * 2));
+		break;
+	case north:
+		bits[y * row_bytes + x / 4] |= static_cast<std::uint8_t>(2 << ((x & 3) * 2));
+		break;
+	case west:
+		carve(x - 1, y, east);
+		break;
+	default:
+		carve(x, y + 1, north);
+		break;
+	}
+}
+
+std::uint32_t Maze::passages(void) const
+{
+	std::uint32_t count = 0;
+	for (std::uint8_t b : bits)
+		for (; b; b &= b - 1)
+			++count;
+	return count;
+}
+
+std::uint32_t Maze::bfs(std::uint32_t from, std::uint32_t to, std::uint32_t& last, int& steps) const
+{
+	std::vector<std::uint64_t> visited((static_cast<std::size_t>(cell_count()) + 63) / 64, 0);
+	std::vector<std::uint32_t> frontier{ from }, next;
+	visited[from / 64] |= 1ull << (from % 64);
+	std::uint32_t reached = 1;
+	last = from;
+	steps = 0;
+
+	while (!frontier.empty()) {
+		for (std::uint32_t c : frontier) {
+			if (c == to) {
+				last = c;
+				return reached;
+			}
+		}
+		last = frontier.front();
+		next.clear();
+		for (std::uint32_t c : frontier) {
+			int x = static_cast<int>(c % w), y = static_cast<int>(c / w);
+			for (int d = 0; d < 4; ++d) {
+				if (!open(x, y, static_cast<Direction>(d)))
+					continue;
+				std::uint32_t n = static_cast<std::uint32_t>((y + step_y[d]) * w + x + step_x[d]);
+				if (visited[n / 64] & (1ull << (n % 64)))
+					continue;
+				visited[n / 64] |= 1ull << (n % 64);
+				next.push_back(n);
+				++reached;
+			}
+		}
+		if (next.empty())
+			break;
+		frontier.swap(next);
+		++steps;
+	}
+	return reached;
+}
+
+int Maze::distance(std::uint32_t from, std::uint32_t to) const
+{
+	std::uint32_t last;
+	int steps;
+	bfs(from, to, last, steps);
+	return (last == to) ? steps : -1;
+}
+
+std::uint32_t Maze::farthest(std::uint32_t from, int& steps) const
+{
+	std::uint32_t last;
+	bfs(from, 0xFFFFFFFFu, last, steps);
+	return last;
+}
+
+bool Maze::connected(void) const
+{
+	std::uint32_t last;
+	int steps;
+	return bfs(0, 0xFFFFFFFFu, last, steps) == cell_count();
+}
+
+bool Maze::wall(int block_x, int block_y) const
+{
+	if (block_x <= 0 || block_y <= 0 || block_x >= 2 * w || block_y >= 2 * h)
+		return true;
+	int x = (block_x - 1) / 2, y = (block_y - 1) / 2;
+	bool odd_x = block_x & 1, odd_y = block_y & 1;
+	if (odd_x && odd_y)
+		return false;                 // cell
+	if (!odd_x && odd_y)
+		return !open(x, y, east);     // between (x, y) and (x + 1, y)
+	if (odd_x && !odd_y)
+		return !open(x, y + 1, north); // between (x, y) and (x, y + 1)
+	return true;                      // corner
+}
+
+// ---- generators
+
+Maze MazeGenerator::generate(Algorithm algorithm, int width, int height, std::uint32_t seed)
+{
+	Maze maze(width, height);
+	switch (algorithm) {
+	case Algorithm::backtracker:
+		backtracker(maze, seed);
+		break;
+	case Algorithm::wilson:
+		wilson(maze, seed);
+		break;
+	case Algorithm::eller:
+		eller(maze, seed);
+		break;
+	case Algorithm::sidewinder:
+		sidewinder(maze, seed);
+		break;
+	}
+	return maze;
+}
+
+const char* MazeGenerator::name(Algorithm algorithm)
+{
+	switch (algorithm) {
+	case Algorithm::wilson: return "wilson";
+	case Algorithm::eller: return "eller";
+	case Algorithm::sidewinder: return "sidewinder";
+	default: return "backtracker";
+	}
+}
+
+MazeGenerator::Algorithm MazeGenerator::parse(const std::string& name)
+{
+	for (Algorithm a : { Algorithm::backtracker, Algorithm::wilson, Algorithm::eller, Algorithm::sidewinder })
+		if (name == MazeGenerator::name(a))
+			return a;
+	throw std::exception(("MazeGenerator: unknown algorithm " + name).c_str());
+}
+
+void MazeGenerator::backtracker(Maze& maze, std::uint32_t seed)
+{
+	// per cell: bit 2 visited, bits 0-1 direction back to the cell it was entered from
+	const int w = maze.width(), h = maze.height();
+	std::vector<std::uint8_t> state(maze.cell_count(), 0);
+	std::mt19937 rng(seed);
+
+	std::uint32_t start = below(rng, maze.cell_count());
+	std::uint32_t c = start;
+	state[c] = 4;
+	for (;;) {
+		int x = static_cast<int>(c % w), y = static_cast<int>(c / w);
+		int options[4], count = 0;
+		for (int d = 0; d < 4; ++d) {
+			int nx = x + step_x[d], ny = y + step_y[d];
+			if (nx >= 0 && ny >= 0 && nx < w && ny < h && !(state[ny * w + nx] & 4))
+				options[count++] = d;
+		}
+
+		if (count > 0) {
+			int d = options[below(rng, count)];
+			maze.carve(x, y, static_cast<Maze::Direction>(d));
+			c = static_cast<std::uint32_t>((y + step_y[d]) * w + x + step_x[d]);
+			state[c] = static_cast<std::uint8_t>(4 | ((d + 2) & 3));
+			continue;
+		}
+
+		// dead end: back the way we came
+		if (c == start)
+			break;
+		int back = state[c] & 3;
+		c = static_cast<std::uint32_t>((y + step_y[back]) * w + x + step_x[back]);
+	}
+}
+
+void MazeGenerator::wilson(Maze& maze, std::uint32_t seed)
+{
+	// per cell: bit 2 in the maze, bits 0-1 last direction the walk left it by; overwriting it erases loops
+	const int w = maze.width(), h = maze.height();
+	const std::uint32_t n = maze.cell_count();
+	std::vector<std::uint8_t> state(n, 0);
+	std::mt19937 rng(seed);
+
+	state[below(rng, n)] = 4;
+	for (std::uint32_t first = 0; first < n; ++first) {
+		if (state[first] & 4)
+			continue;
+
+		// random walk until it meets the maze
+		std::uint32_t c = first;
+		while (!(state[c] & 4)) {
+			int x = static_cast<int>(c % w), y = static_cast<int>(c / w);
+			int d, nx, ny;
+			do {
+				d = static_cast<int>(below(rng, 4));
+				nx = x + step_x[d];
+				ny = y + step_y[d];
+			} while (nx < 0 || ny < 0 || nx >= w || ny >= h);
+			state[c] = static_cast<std::uint8_t>(d);
+			c = static_cast<std::uint32_t>(ny * w + nx);
+		}
+
+		// carve the loop-erased path
+		c = first;
+		while (!(state[c] & 4)) {
+			int x = static_cast<int>(c % w), y = static_cast<int>(c / w);
+			int d = state[c] & 3;
+			maze.carve(x, y, static_cast<Maze::Direction>(d));
+			state[c] = 4;
+			c = static_cast<std::uint32_t>((y + step_y[d]) * w + x + step_x[d]);
+		}
+	}
+}
+
+void MazeGenerator::eller(Maze& maze, std::uint32_t seed)
+{
+	// set labels of the current row, union-find over them; labels are renumbered every row so all stays O(width)
+	const int w = maze.width(), h = maze.height();
+	const std::uint32_t none = 0xFFFFFFFFu;
+	std::vector<std::uint32_t> label(w), parent(2 * static_cast<std::size_t>(w));
+	std::vector<std::uint32_t> picked(2 * static_cast<std::size_t>(w)), members(2 * static_cast<std::size_t>(w)), renumber(2 * static_cast<std::size_t>(w));
+	std::vector<std::uint8_t> down(w);
+	std::mt19937 rng(seed);
+
+	auto find = [&](std::uint32_t a) {
+		while (parent[a] != a)
+			a = parent[a] = parent[parent[a]];
+		return a;
+	};
+
+	std::iota(label.begin(), label.end(), 0u);
+	std::uint32_t labels = static_cast<std::uint32_t>(w);
+	for (int y = 0; y < h; ++y) {
+		std::iota(parent.begin(), parent.begin() + labels, 0u);
+		bool last = (y == h - 1);
+
+		// join neighbors of different sets, all of them in the last row
+		for (int x = 0; x + 1 < w; ++x) {
+			std::uint32_t a = find(label[x]), b = find(label[x + 1]);
+			if (a != b && (last || below(rng, 2))) {
+				maze.carve(x, y, Maze::east);
+				parent[a] = b;
+			}
+		}
+		if (last)
+			break;
+
+		// every set goes down at least once: random cells, plus one picked per set by reservoir sampling
+		std::fill(members.begin(), members.begin() + labels, 0u);
+		std::fill(picked.begin(), picked.begin() + labels, none);
+		for (int x = 0; x < w; ++x) {
+			std::uint32_t r = find(label[x]);
+			down[x] = static_cast<std::uint8_t>(below(rng, 2));
+			if (below(rng, ++members[r]) == 0)
+				picked[r] = static_cast<std::uint32_t>(x);
+		}
+		for (std::uint32_t r = 0; r < labels; ++r)
+			if (picked[r] != none)
+				down[picked[r]] = 1;
+
+		// next row: cells below keep their set under a new compact label, the others start new sets
+		std::fill(renumber.begin(), renumber.begin() + labels, none);
+		std::uint32_t next = 0;
+		for (int x = 0; x < w; ++x) {
+			if (!down[x])
+				continue;
+			maze.carve(x, y, Maze::south);
+			std::uint32_t r = find(label[x]);
+			if (renumber[r] == none)
+				renumber[r] = next++;
+		}
+		for (int x = 0; x < w; ++x)
+			label[x] = down[x] ? renumber[find(label[x])] : next++;
+		labels = next;
+	}
+}
+
+void MazeGenerator::sidewinder(Maze& maze, std::uint32_t seed)
+{
+	// each row has its own generator, so the maze does not depend on the number of threads
+	const int w = maze.width();
+	std::vector<int> rows(maze.height());
+	std::iota(rows.begin(), rows.end(), 0);
+	std::for_each(std::execution::par, rows.begin(), rows.end(), [&](int y) {
+		std::seed_seq row_seed{ seed, static_cast<std::uint32_t>(y) };
+		std::mt19937 rng(row_seed);
+		int run_start = 0;
+		for (int x = 0; x < w; ++x) {
+			bool close_run = (x + 1 == w) || (y > 0 && below(rng, 2) == 0);
+			if (!close_run) {
+				maze.carve(x, y, Maze::east);
+				continue;
+			}
+			// one way north from every run, the first row is a single corridor
+			if (y > 0)
+				maze.carve(run_start + static_cast<int>(below(rng, static_cast<std::uint32_t>(x - run_start + 1))), y, Maze::north);
+			run_start = x + 1;
+		}
+	});
+}
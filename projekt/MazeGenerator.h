@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Perfect maze: every cell reachable from every other by exactly one path
+//
+// Cells are stored as 2 bits, passage east and passage north, 4 cells per byte.
+// Each row starts on its own byte, and carving east or north only writes the row
+// of the cell, so different rows can be carved in parallel. An 8192x8192 maze takes
+// 16 MiB. For the renderer it is read as a block map of (2w + 1) x (2h + 1), with
+// cell (x, y) at block (2x + 1, 2y + 1) and walls between and around the cells.
+class Maze {
+public:
+	enum Direction { east, north, west, south };
+
+	Maze(void) = default;
+	Maze(int width, int height);
+
+	int width(void) const { return w; }
+	int height(void) const { return h; }
+	std::uint32_t cell_count(void) const { return static_cast<std::uint32_t>(w) * static_cast<std::uint32_t>(h); }
+	std::size_t bytes(void) const { return bits.size(); }
+
+	bool open(int x, int y, Direction d) const;
+	// west and south carve into the neighbor's row
+	void carve(int x, int y, Direction d);
+	std::uint32_t passages(void) const; // w * h - 1 in a perfect maze
+
+	// breadth first search; steps between two cells, -1 if there is no path
+	int distance(std::uint32_t from, std::uint32_t to) const;
+	// the cell furthest from 'from', its distance in steps
+	std::uint32_t farthest(std::uint32_t from, int& steps) const;
+	// every cell reachable from cell 0
+	bool connected(void) const;
+
+	bool wall(int block_x, int block_y) const;
+
+private:
+	// visits cells in order of distance from 'from' until 'to' is reached; returns the cells reached
+	std::uint32_t bfs(std::uint32_t from, std::uint32_t to, std::uint32_t& last, int& steps) const;
+
+	int w = 0, h = 0;
+	std::size_t row_bytes = 0;
+	std::vector<std::uint8_t> bits;
+};
+
+// Seeded maze generation
+//
+// Same algorithm, size and seed give the same maze on every platform: numbers are
+// drawn from std::mt19937 and scaled without the standard distributions, whose
+// output differs between libraries.
+// - backtracker: depth first carving, long winding corridors; the way back is
+//   kept in the cells, not on a stack
+// - wilson: loop-erased random walks, an unbiased pick among all perfect mazes;
+//   slow to start on large grids
+// - eller: row by row with O(width) extra memory, sets merged by union-find
+// - sidewinder: rows are independent and carved in parallel, the top row is one corridor
+class MazeGenerator {
+public:
+	enum class Algorithm { backtracker, wilson, eller, sidewinder };
+
+	static Maze generate(Algorithm algorithm, int width, int height, std::uint32_t seed);
+
+	static const char* name(Algorithm algorithm);
+	static Algorithm parse(const std::string& name); // throws on an unknown name
+
+private:
+	static void backtracker(Maze& maze, std::uint32_t seed);
+	static void wilson(Maze& maze, std::uint32_t seed);
+	static void eller(Maze& maze, std::uint32_t seed);
+	static void sidewinder(Maze& maze, std::uint32_t seed);
+};
@@ -17,13 +17,8 @@
 
 #include "ShaderProgram.h"
 #include "OBJloader.h"
-
-//vertex description
-struct vertex {
-	glm::vec3 position;
-	glm::vec2 texcoord;
-	glm::vec3 normal;
-};
+#include "GeometryPool.h"
+#include "Lights.h"
 
 class Mesh
 {
@@ -33,6 +28,7 @@ public:
 	GLuint VAO_ID = 0;
 	GLuint VBO_ID = 0;
 	GLuint EBO_ID = 0;
+	GeometryRange geometry; // location inside GeometryPool
 	GLenum primitive = GL_POINTS;
 
 
@@ -41,9 +37,11 @@ public:
 	glm::vec4 specular_material;
 	float shininess;
 	GLuint texture = 0;
-
-	glm::vec3 viewPos;
-	glm::vec3 flashLightDirection;
+	int texture_layer = -1; // layer in the array texture bound to unit 1, -1 = use texture
+	bool transparent = false; // blended, drawn back to front after opaque meshes
+	GLuint object_index = 0; // entry in ObjectBuffer, selected by baseInstance
+	glm::vec4 lightmap_rect = glm::vec4(0.0f); // scale xy, offset zw in the lightmap atlas, 0 = not lightmapped
+	int lightmap_layer = 0; // page of the lightmap atlas
 
 	ShaderProgram mesh_shader;
 
@@ -70,71 +68,93 @@ public:
 		init_VAO();
 	}
 
-	void draw(const glm::mat4 & projection_matrix, const glm::mat4 & view_matrix, const glm::mat4 & model_matrix) {
+	// per-object data comes from the ObjectBuffer, per-frame uniforms from setFrameUniforms()
+	void draw(void) {
 		mesh_shader.activate();
 
-		// P,V,M
-		mesh_shader.setUniform("uPm", projection_matrix);
-		mesh_shader.setUniform("uVm", view_matrix);
-		mesh_shader.setUniform("uMm", model_matrix);
+		// Bind texture
+		GLState::activeTexture(GL_TEXTURE0);
+		if (texture != 0)
+			GLState::bindTexture(GL_TEXTURE_2D, texture);
+
+		GLState::bindVertexArray(VAO_ID);
+		if (indices.empty())
+			glDrawArraysInstancedBaseInstance(primitive, geometry.base_vertex, geometry.vertex_count, 1, object_index);
+		else
+			glDrawElementsInstancedBaseVertexBaseInstance(primitive, geometry.index_count, GL_UNSIGNED_INT,
+				reinterpret_cast<void*>(static_cast<std::size_t>(geometry.first_index) * sizeof(GLuint)), 1, geometry.base_vertex, object_index);
+	}
+
+	// position-only draw for the depth pre-pass, depth program must be active
+	void drawDepth(void) const {
+		GLState::bindVertexArray(GeometryPool::get().depth_vao());
+		if (indices.empty())
+			glDrawArraysInstancedBaseInstance(primitive, geometry.base_vertex, geometry.vertex_count, 1, object_index);
+		else
+			glDrawElementsInstancedBaseVertexBaseInstance(primitive, geometry.index_count, GL_UNSIGNED_INT,
+				reinterpret_cast<void*>(static_cast<std::size_t>(geometry.first_index) * sizeof(GLuint)), 1, geometry.base_vertex, object_index);
+	}
+
+	// shared by all shaders using obj.vert/obj.frag, set once per program per frame
+	static void setFrameUniforms(ShaderProgram& shader, const glm::mat4& projection_matrix, const glm::mat4& view_matrix, const glm::vec3& viewPos, const glm::vec3& flashLightPosition, const glm::vec3& flashLightDirection) {
+		shader.activate();
 
-		// Material
-		mesh_shader.setUniform("specular_material", specular_material);
-		mesh_shader.setUniform("shininess", shininess);
+		// P,V
+		shader.setUniform("uPm", projection_matrix);
+		shader.setUniform("uVm", view_matrix);
 
 		// View Position
-		mesh_shader.setUniform("viewPos", viewPos);
+		shader.setUniform("viewPos", viewPos);
 
-		// Point Light
-		mesh_shader.setUniform("pointLight.position", glm::vec3(view_matrix * glm::vec4(glm::vec3(5.0f, 10.0f, 5.0f), 1.0))); // Transform world-space light position to view-space light position
-		mesh_shader.setUniform("pointLight.ambient", glm::vec3(.5f));
-		mesh_shader.setUniform("pointLight.diffuse", glm::vec3(.5f));
-		mesh_shader.setUniform("pointLight.specular", glm::vec3(.5f));
-		mesh_shader.setUniform("pointLight.constant", 1.0f);
-		mesh_shader.setUniform("pointLight.linear", 0.045f);
-		mesh_shader.setUniform("pointLight.quadratic", 0.0075f);
+		shader.setUniform("ourTexture", 0);
+		shader.setUniform("ourTextureArray", 1);
+		shader.setUniform("lightmap", 2);
+		shader.setUniform("sunShadowStatic", 3);
+		shader.setUniform("sunShadowDynamic", 4);
+
+		// Point lights come from ClusteredLights
 
 		// Ambient light (is coming from every direction)
-		mesh_shader.setUniform("ambientLight.ambient", glm::vec3(0.05f));
-		mesh_shader.setUniform("ambientLight.diffuse", glm::vec3(0.05f));
-		mesh_shader.setUniform("ambientLight.specular", glm::vec3(0.05f));
+		const AmbientLight ambient;
+		shader.setUniform("ambientLight.ambient", ambient.ambient);
+		shader.setUniform("ambientLight.diffuse", ambient.diffuse);
+		shader.setUniform("ambientLight.specular", ambient.specular);
 
 		// Spotlight - Flashlight
-		mesh_shader.setUniform("spotLight.position", glm::vec3(view_matrix * glm::vec4(viewPos, 1.0)));
-		mesh_shader.setUniform("spotLight.direction", glm::vec3(view_matrix * glm::vec4(flashLightDirection, 0.0)));
+		shader.setUniform("spotLight.position", glm::vec3(view_matrix * glm::vec4(flashLightPosition, 1.0)));
+		shader.setUniform("spotLight.direction", glm::vec3(view_matrix * glm::vec4(flashLightDirection, 0.0)));
 
-		mesh_shader.setUniform("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-		mesh_shader.setUniform("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
+		shader.setUniform("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
+		shader.setUniform("spotLight.outerCutOff", glm::cos(glm::radians(17.5f)));
 
-		mesh_shader.setUniform("spotLight.ambient", glm::vec3(1.0f));
-		mesh_shader.setUniform("spotLight.diffuse", glm::vec3(1.0f));
-		mesh_shader.setUniform("spotLight.specular", glm::vec3(1.0f));
+		shader.setUniform("spotLight.ambient", glm::vec3(1.0f));
+		shader.setUniform("spotLight.diffuse", glm::vec3(1.0f));
+		shader.setUniform("spotLight.specular", glm::vec3(1.0f));
 
-		mesh_shader.setUniform("spotLight.constant", 1.0f);
-		mesh_shader.setUniform("spotLight.linear", 0.22f);
-		mesh_shader.setUniform("spotLight.quadratic", 0.20f);
+		shader.setUniform("spotLight.constant", 1.0f);
+		shader.setUniform("spotLight.linear", 0.22f);
+		shader.setUniform("spotLight.quadratic", 0.20f);
 
 		// Directional light - Sun
-		mesh_shader.setUniform("directionalLight.direction", glm::vec3(view_matrix * glm::vec4(glm::vec3(-0.2f, -1.0f, -0.3f), 0.0)));
-		mesh_shader.setUniform("directionalLight.ambient", glm::vec3(0.1f));
-		mesh_shader.setUniform("directionalLight.diffuse", glm::vec3(0.2f));
-		mesh_shader.setUniform("directionalLight.specular", glm::vec3(0.3f));
-
-		// Bind texture
-		if (texture != 0)
-			glBindTexture(GL_TEXTURE_2D, texture);
-		glActiveTexture(GL_TEXTURE0);
-		mesh_shader.setUniform("ourTexture", 0);
-
-		glBindVertexArray(VAO_ID);
-		if (indices.empty())
-			glDrawArrays(primitive, 0, vertices.size());
-		else
-			glDrawElements(primitive, indices.size(), GL_UNSIGNED_INT, 0);
+		const DirectionalLight sun;
+		shader.setUniform("directionalLight.direction", glm::vec3(view_matrix * glm::vec4(sun.direction, 0.0)));
+		shader.setUniform("directionalLight.ambient", sun.ambient);
+		shader.setUniform("directionalLight.diffuse", sun.diffuse);
+		shader.setUniform("directionalLight.specular", sun.specular);
 	}
 
-	void draw(const glm::mat4& projection_matrix, const glm::mat4& view_matrix) {
-		this->draw(projection_matrix, view_matrix, this->model_matrix);
+	// local space bounding sphere (center of AABB, farthest vertex), xyz = center, w = radius
+	glm::vec4 calculateBoundingSphere(void) const {
+		glm::vec3 lo = vertices[0].position, hi = vertices[0].position;
+		for (const vertex& vert : vertices) {
+			lo = glm::min(lo, vert.position);
+			hi = glm::max(hi, vert.position);
+		}
+		glm::vec3 center = (lo + hi) * 0.5f;
+		float radius = 0.0f;
+		for (const vertex& vert : vertices)
+			radius = glm::max(radius, glm::distance(center, vert.position));
+		return glm::vec4(center, radius);
 	}
 
 	glm::vec3 calculateDimensions(float scale = 1.0f){
@@ -154,33 +174,13 @@ public:
 
 private:
 	void init_VAO(void) {
-		// create VAO = data description
-		glGenVertexArrays(1, &VAO_ID);
-		glGenBuffers(1, &EBO_ID);
-		glGenBuffers(1, &VBO_ID);
-
-		glBindVertexArray(VAO_ID);
-
-		// indices
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_ID);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), &indices[0], GL_STATIC_DRAW);
-
-		// create vertex buffer and fill with data
-		glBindBuffer(GL_ARRAY_BUFFER, VBO_ID);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertex), vertices.data(), GL_STATIC_DRAW);
-
-		//explain GPU the memory layout of the data...
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(0 + offsetof(vertex, position)));
-		glEnableVertexAttribArray(0);
-
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(0 + offsetof(vertex, texcoord)));
-		glEnableVertexAttribArray(1);
-
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), reinterpret_cast<void*>(0 + offsetof(vertex, normal)));
-		glEnableVertexAttribArray(2);
+		// sub-allocate in the shared buffers, all meshes of this vertex format use one VAO
+		GeometryPool& pool = GeometryPool::get();
+		geometry = pool.add(vertices, indices);
 
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		VAO_ID = pool.vao();
+		VBO_ID = pool.vbo();
+		EBO_ID = pool.ebo();
 	}
 
 };
@@ -0,0 +1,77 @@
+#include <numeric>
+
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include "ObjectBuffer.h"
+#include "GeometryPool.h"
+#include "GLState.h"
+
+void ObjectBuffer::init(void)
+{
+	glGenBuffers(1, &instance_id_buffer);
+}
+
+void ObjectBuffer::add(Mesh& mesh)
+{
+	if (instance_id_buffer == 0)
+		init();
+
+	mesh.object_index = static_cast<GLuint>(meshes.size());
+	meshes.push_back(&mesh);
+}
+
+void ObjectBuffer::update(const glm::mat4& view_matrix, StreamBuffer& stream)
+{
+	if (meshes.empty())
+		return;
+
+	if (capacity < meshes.size()) {
+		capacity = meshes.size();
+
+		// aInstance = baseInstance + gl_InstanceID, read from 0..N-1 with divisor 1
+		std::vector<GLuint> ids(capacity);
+		std::iota(ids.begin(), ids.end(), 0);
+		glBindBuffer(GL_ARRAY_BUFFER, instance_id_buffer);
+		glBufferData(GL_ARRAY_BUFFER, ids.size() * sizeof(GLuint), ids.data(), GL_STATIC_DRAW);
+
+		for (GLuint vao : { GeometryPool::get().vao(), GeometryPool::get().depth_vao() }) {
+			GLState::bindVertexArray(vao);
+			glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(GLuint), reinterpret_cast<void*>(0));
+			glVertexAttribDivisor(3, 1);
+			glEnableVertexAttribArray(3);
+		}
+		GLState::bindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// the caller reserved room for this before begin_frame(), see StreamBuffer::reserve()
+	StreamBuffer::Allocation a = stream.allocate(bytes_per_frame());
+	ObjectData* data = static_cast<ObjectData*>(a.data);
+
+	// one 3x3 inverse per object on the CPU instead of a 4x4 inverse per vertex
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		const Mesh& m = *meshes[i];
+		data[i].model = m.model_matrix;
+		data[i].normal = glm::mat4(glm::inverseTranspose(glm::mat3(view_matrix * m.model_matrix)));
+		data[i].specular = m.specular_material;
+		data[i].lightmap_rect = m.lightmap_rect;
+		data[i].lightmap_layer = m.lightmap_layer;
+		data[i].shininess = m.shininess;
+		data[i].texture_layer = m.texture_layer;
+	}
+
+	stream.commit(a);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, stream.id(), a.offset, a.size);
+}
+
+void ObjectBuffer::clear(void)
+{
+	if (instance_id_buffer == 0)
+		return;
+
+	glDeleteBuffers(1, &instance_id_buffer);
+	instance_id_buffer = 0;
+	capacity = 0;
+
+	meshes.clear();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "StreamBuffer.h"
+
+// Per-object draw data in a shader storage buffer
+//
+// Model matrix, precomputed view space normal matrix and material of every
+// registered mesh are packed into one SSBO (binding 0), written each frame straight
+// into the per-frame StreamBuffer region.
+// obj.vert fetches its entry with aInstance, a divisor-1 attribute reading an
+// identity buffer, so the baseInstance of a draw selects the object.
+class ObjectBuffer {
+public:
+	static constexpr GLuint binding = 0;
+
+	ObjectBuffer(void) = default;
+	ObjectBuffer(const ObjectBuffer&) = delete;
+
+	// assigns mesh.object_index; mesh must stay at the same address
+	void add(Mesh& mesh);
+	// recompute normal matrices for this view, write into stream and bind
+	void update(const glm::mat4& view_matrix, StreamBuffer& stream);
+	void clear(void); // needs current GL context
+
+	unsigned int count(void) const { return static_cast<unsigned int>(meshes.size()); }
+	std::size_t bytes_per_frame(void) const { return meshes.size() * sizeof(ObjectData); }
+
+private:
+	// std430 layout, must match obj.vert and cull.comp
+	struct ObjectData {
+		glm::mat4 model;
+		glm::mat4 normal;   // transpose(inverse(V * M)), upper 3x3 used
+		glm::vec4 specular;
+		glm::vec4 lightmap_rect;
+		float shininess;
+		GLint texture_layer;
+		GLint lightmap_layer;
+		GLuint pad;
+	};
+
+	void init(void);
+
+	GLuint instance_id_buffer = 0;
+	std::size_t capacity = 0;
+
+	std::vector<Mesh*> meshes;
+};
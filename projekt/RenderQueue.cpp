@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cstring>
+
+#include "RenderQueue.h"
+
+namespace {
+	constexpr std::uint64_t field_mask = 0x3ff; // 10 bits per state id
+	constexpr std::uint64_t depth_mask = 0xffffff;
+
+	// positive floats keep their order when compared as integers,
+	// top 24 bits of the representation are enough for sorting
+	std::uint64_t quantize_depth(float depth)
+	{
+		depth = std::max(depth, 0.0f);
+		std::uint32_t bits;
+		std::memcpy(&bits, &depth, sizeof(bits));
+		return (bits >> 8) & depth_mask;
+	}
+}
+
+std::uint64_t RenderQueue::make_key(const Mesh& mesh, float depth)
+{
+	const std::uint64_t program = mesh.mesh_shader.getID() & field_mask;
+	const std::uint64_t texture = mesh.texture & field_mask;
+	const std::uint64_t vao = mesh.VAO_ID & field_mask;
+	const std::uint64_t state = (program << 20) | (texture << 10) | vao;
+
+	if (mesh.transparent)
+		return (1ull << 63) | ((depth_mask - quantize_depth(depth)) << 30) | state;
+	else
+		return (state << 24) | quantize_depth(depth);
+}
+
+void RenderQueue::submit(Mesh& mesh, float depth)
+{
+	queue.push_back(RenderCommand{ make_key(mesh, depth), &mesh, depth });
+}
+
+void RenderQueue::sort(void)
+{
+	std::sort(queue.begin(), queue.end(), [](const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; });
+
+	frame_stats = Stats();
+	const Mesh* prev = nullptr;
+	for (auto const& cmd : queue) {
+		const Mesh& m = *cmd.mesh;
+		if (m.transparent)
+			frame_stats.blended++;
+		else
+			frame_stats.opaque++;
+
+		if (!prev || prev->mesh_shader.getID() != m.mesh_shader.getID())
+			frame_stats.program_changes++;
+		if (!prev || prev->texture != m.texture)
+			frame_stats.texture_changes++;
+		if (!prev || prev->VAO_ID != m.VAO_ID)
+			frame_stats.vao_changes++;
+		prev = &m;
+	}
+	frame_stats.draws = static_cast<unsigned int>(queue.size());
+}
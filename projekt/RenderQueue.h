@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Mesh.h"
+
+// One draw in the frame
+struct RenderCommand {
+	std::uint64_t key;
+	Mesh* mesh;
+	float depth; // view space distance along camera axis
+};
+
+// Render queue with 64-bit sort keys
+//
+// Opaque key:  [63]=0 | program:10 | texture:10 | VAO:10 | ... | depth:24 (front to back)
+// Blended key: [63]=1 | inverted depth:24 (back to front) | program:10 | texture:10 | VAO:10
+//
+// Opaque draws are grouped by state to minimise switches, inside a group nearest
+// first for early depth rejection. Blended draws always come last, farthest first.
+class RenderQueue {
+public:
+	struct Stats {
+		unsigned int draws = 0;
+		unsigned int opaque = 0;
+		unsigned int blended = 0;
+		unsigned int program_changes = 0;
+		unsigned int texture_changes = 0;
+		unsigned int vao_changes = 0;
+	};
+
+	void clear(void) { queue.clear(); }
+	void submit(Mesh& mesh, float depth);
+	// sort and count state changes of the resulting order
+	void sort(void);
+
+	const std::vector<RenderCommand>& commands(void) const { return queue; }
+	const Stats& stats(void) const { return frame_stats; }
+
+private:
+	static std::uint64_t make_key(const Mesh& mesh, float depth);
+
+	std::vector<RenderCommand> queue;
+	Stats frame_stats;
+};
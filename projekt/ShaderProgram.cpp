@@ -14,6 +14,15 @@ ShaderProgram::ShaderProgram(const std::filesystem::path& VS_file, const std::fi
 	ID = link_shader(shader_names);
 }
 
+ShaderProgram::ShaderProgram(const std::filesystem::path& CS_file)
+{
+	std::vector<GLuint> shader_names;
+
+	shader_names.push_back(compile_shader(CS_file, GL_COMPUTE_SHADER));
+
+	ID = link_shader(shader_names);
+}
+
 GLuint ShaderProgram::compile_shader(const std::filesystem::path& source_file, const GLenum type)
 {
 	GLuint name;
@@ -12,16 +12,20 @@
 #include <glm/ext.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include "GLState.h"
+
 
 class ShaderProgram {
 public:
 	// you can add more constructors for pipeline with GS, TS etc.
 	ShaderProgram(void) = default;
 	ShaderProgram(const std::filesystem::path& VS_file, const std::filesystem::path& FS_file);
+	explicit ShaderProgram(const std::filesystem::path& CS_file); // compute
 
-	void activate(void) { glUseProgram(ID); };
-	void deactivate(void) { glUseProgram(0); };
-	void clear(void) { deactivate();  glDeleteProgram(ID); ID = 0; };
+	void activate(void) { GLState::useProgram(ID); };
+	void deactivate(void) { GLState::useProgram(0); };
+	void clear(void) { deactivate();  GLState::deleteProgram(ID); ID = 0; };
+	GLuint getID(void) const { return ID; };
 
 	void setUniform(const std::string& name, const float in_float) {
 		auto loc = getUniformLocation(name);
@@ -37,6 +41,13 @@ public:
 		}
 	}
 	
+	void setUniform(const std::string& name, const glm::vec2& in_vec2) {
+		auto loc = getUniformLocation(name);
+		if (loc >= 0) {
+			glUniform2fv(loc, 1, glm::value_ptr(in_vec2));
+		}
+	}
+
 	void setUniform(const std::string& name, glm::vec3 in_vec3) {
 		auto loc = getUniformLocation(name);
 		if (loc >= 0) {
@@ -51,6 +62,13 @@ public:
 		}
 	}
 
+	void setUniform(const std::string& name, unsigned int in_uint) {
+		auto loc = getUniformLocation(name);
+		if (loc >= 0) {
+			glUniform1ui(loc, in_uint);
+		}
+	}
+
 	void setUniform(const std::string& name, const glm::mat4& mat4) {
 		auto loc = getUniformLocation(name);
 		if (loc >= 0) {
@@ -59,7 +77,7 @@ public:
 	}
 
 private:
-	GLuint ID;
+	GLuint ID = 0;
 
 	GLint getUniformLocation(const std::string& name) {
 		auto loc = glGetUniformLocation(ID, name.c_str());
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <chrono>
+
+#include "StreamBuffer.h"
+
+void StreamBuffer::init(std::size_t bytes)
+{
+	GLint ssbo_alignment = 0, ubo_alignment = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssbo_alignment);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+	alignment = std::max<std::size_t>({ 16, static_cast<std::size_t>(ssbo_alignment), static_cast<std::size_t>(ubo_alignment) });
+
+	region_bytes = (bytes + alignment - 1) / alignment * alignment;
+	GLsizeiptr total = static_cast<GLsizeiptr>(region_bytes * regions);
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+
+	is_persistent = GLEW_ARB_buffer_storage;
+	if (is_persistent) {
+		// coherent: writes become visible to commands issued afterwards, no explicit flush
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+		mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags));
+		if (!mapped)
+			throw std::exception("StreamBuffer: persistent mapping failed");
+	}
+	else {
+		glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW);
+		staging.resize(region_bytes);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	region = 0;
+	head = 0;
+}
+
+void StreamBuffer::reserve(std::size_t bytes)
+{
+	if (in_frame)
+		throw std::exception("StreamBuffer: reserve() inside a frame, call it before begin_frame()");
+	if (buffer != 0 && bytes <= region_bytes)
+		return;
+
+	// regions still in flight may be read from the old buffer
+	for (GLsync& fence : fences) {
+		if (fence) {
+			wait(fence);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	std::size_t size = std::max(bytes, region_bytes * 2);
+	clear();
+	init(size);
+}
+
+void StreamBuffer::wait(GLsync fence)
+{
+	// fast path: already done
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+	do {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+	} while (result == GL_TIMEOUT_EXPIRED);
+	auto end = std::chrono::steady_clock::now();
+
+	current.wait_ms += std::chrono::duration<double, std::milli>(end - start).count();
+	current.waits++;
+}
+
+void StreamBuffer::begin_frame(void)
+{
+	in_frame = true;
+	if (buffer == 0)
+		return;
+
+	if (fences[region]) {
+		wait(fences[region]);
+		glDeleteSync(fences[region]);
+		fences[region] = nullptr;
+	}
+	head = 0;
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(std::size_t bytes)
+{
+	if (head + bytes > region_bytes)
+		throw std::exception("StreamBuffer: region overflow, reserve() more before begin_frame()");
+
+	Allocation a;
+	a.offset = static_cast<GLintptr>(region * region_bytes + head);
+	a.size = static_cast<GLsizeiptr>(bytes);
+	a.data = is_persistent ? mapped + a.offset : staging.data() + head; // staging holds one region
+
+	head = (head + bytes + alignment - 1) / alignment * alignment;
+	head = std::min(head, region_bytes);
+	current.bytes += bytes;
+	return a;
+}
+
+void StreamBuffer::commit(const Allocation& a)
+{
+	if (is_persistent || a.size == 0)
+		return;
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, a.offset, a.size, a.data);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::end_frame(void)
+{
+	if (buffer != 0) {
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		region = (region + 1) % regions;
+		head = 0;
+	}
+	in_frame = false;
+
+	last = current;
+	current = Stats();
+}
+
+void StreamBuffer::clear(void)
+{
+	if (buffer == 0)
+		return;
+
+	for (GLsync& fence : fences) {
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	if (is_persistent) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	mapped = nullptr;
+	staging.clear();
+	region_bytes = 0;
+	in_frame = false;
+}
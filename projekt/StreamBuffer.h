@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+
+// OpenGL Extension Wrangler
+#include <GL/glew.h>
+#include <GL/wglew.h> //WGLEW = Windows GL Extension Wrangler (change for different platform)
+
+// Ring of per-frame regions in one persistently mapped buffer
+//
+// The buffer is created with glBufferStorage and stays mapped (persistent, coherent),
+// split into three regions. Each frame writes into its own region while the GPU may
+// still read the previous two; a fence placed at end_frame() guards the region until
+// it comes around again. Time spent waiting on these fences is the stall metric.
+// Without ARB_buffer_storage writes go to a CPU copy uploaded by glBufferSubData.
+class StreamBuffer {
+public:
+	static constexpr unsigned int regions = 3;
+
+	struct Allocation {
+		void* data = nullptr;   // write here
+		GLintptr offset = 0;    // for glBindBufferRange / attribute offsets
+		GLsizeiptr size = 0;
+	};
+
+	struct Stats {
+		double wait_ms = 0.0;       // blocked on fences
+		unsigned int waits = 0;     // fences not yet signaled when needed
+		std::size_t bytes = 0;      // written
+	};
+
+	StreamBuffer(void) = default;
+	StreamBuffer(const StreamBuffer&) = delete;
+
+	// make every region at least this big, only between end_frame() and begin_frame():
+	// replacing the buffer waits for the GPU and would invalidate this frame's allocations
+	void reserve(std::size_t region_bytes);
+	// wait until the current region is free again
+	void begin_frame(void);
+	// sub-allocate from the current region, aligned for SSBO/UBO binding
+	Allocation allocate(std::size_t bytes);
+	// call when done writing an allocation, before the GPU uses it (no-op when persistent)
+	void commit(const Allocation& allocation);
+	// fence the current region and move to the next one
+	void end_frame(void);
+	void clear(void); // needs current GL context
+
+	GLuint id(void) const { return buffer; }
+	bool persistent(void) const { return is_persistent; }
+	std::size_t region_size(void) const { return region_bytes; }
+
+	const Stats& lastFrame(void) const { return last; }
+
+private:
+	void init(std::size_t region_bytes);
+	void wait(GLsync fence);
+
+	GLuint buffer = 0;
+	bool is_persistent = false;
+	unsigned char* mapped = nullptr;       // whole buffer, persistent path only
+	std::vector<unsigned char> staging;    // one region, fallback path only
+
+	std::size_t region_bytes = 0;
+	std::size_t alignment = 256;
+	unsigned int region = 0;               // being written this frame
+	std::size_t head = 0;                  // next free byte in region
+	bool in_frame = false;                 // between begin_frame() and end_frame()
+	GLsync fences[regions] = {};
+
+	Stats current;
+	Stats last;
+};
@@ -0,0 +1,166 @@
+#include <algorithm>
+
+#include "SunShadows.h"
+#include "GLState.h"
+#include "Lights.h"
+
+namespace {
+	// clip space to [0,1] texture coordinates and depth
+	const glm::mat4 bias_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) * glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+
+	float max_scale(const glm::mat4& m)
+	{
+		return glm::max(glm::length(glm::vec3(m[0])), glm::max(glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2]))));
+	}
+}
+
+void SunShadows::create(Map& map, int size)
+{
+	map.size = size;
+
+	glGenTextures(1, &map.texture);
+	GLState::bindTexture(GL_TEXTURE_2D, map.texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	// linear + compare mode = 2x2 hardware PCF
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	// outside the map = lit
+	const GLfloat border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+
+	glGenFramebuffers(1, &map.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, map.framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, map.texture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::exception("Shadow map framebuffer incomplete");
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void SunShadows::init(int static_size, int dynamic_size)
+{
+	create(static_map, static_size);
+	create(dynamic_map, dynamic_size);
+}
+
+void SunShadows::set_static(const std::vector<Mesh*>& meshes)
+{
+	static_meshes = meshes;
+
+	// world bounds of the static geometry
+	glm::vec3 lo(1e30f), hi(-1e30f);
+	for (const Mesh* m : meshes) {
+		glm::vec4 sphere = m->calculateBoundingSphere();
+		glm::vec3 center = glm::vec3(m->model_matrix * glm::vec4(glm::vec3(sphere), 1.0f));
+		float radius = sphere.w * max_scale(m->model_matrix);
+		lo = glm::min(lo, center - radius);
+		hi = glm::max(hi, center + radius);
+	}
+	glm::vec3 center = (lo + hi) * 0.5f;
+	float radius = glm::max(glm::length(hi - lo) * 0.5f, 1.0f);
+
+	// sun looks at the maze centre from outside its bounding sphere
+	const DirectionalLight sun;
+	glm::vec3 dir = glm::normalize(sun.direction);
+	glm::vec3 up = std::abs(dir.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	light_view = glm::lookAt(center - dir * (radius + 1.0f), center, up);
+	depth_range = 2.0f * radius + 2.0f;
+	static_map.projection = glm::ortho(-radius, radius, -radius, radius, 0.0f, depth_range);
+
+	static_dirty = true;
+}
+
+void SunShadows::set_dynamic(const std::vector<Mesh*>& meshes)
+{
+	dynamic_meshes = meshes;
+	dynamic_spheres.clear();
+	for (const Mesh* m : meshes)
+		dynamic_spheres.push_back(m->calculateBoundingSphere());
+}
+
+void SunShadows::fit_dynamic(void)
+{
+	// light space bounds of the casters; receivers outside them can not be shadowed by them
+	glm::vec2 lo(1e30f), hi(-1e30f);
+	for (size_t i = 0; i < dynamic_meshes.size(); ++i) {
+		const glm::mat4& model = dynamic_meshes[i]->model_matrix;
+		glm::vec3 center = glm::vec3(light_view * model * glm::vec4(glm::vec3(dynamic_spheres[i]), 1.0f));
+		float radius = dynamic_spheres[i].w * max_scale(model);
+		lo = glm::min(lo, glm::vec2(center) - radius);
+		hi = glm::max(hi, glm::vec2(center) + radius);
+	}
+	if (dynamic_meshes.empty())
+		lo = hi = glm::vec2(0.0f);
+
+	// square and snapped to whole texels, so the map does not shimmer while objects move
+	float extent = glm::max(glm::max(hi.x - lo.x, hi.y - lo.y), 0.1f);
+	float texel = extent / dynamic_map.size;
+	glm::vec2 center = glm::floor((lo + hi) * 0.5f / texel) * texel;
+	float half = extent * 0.5f + texel;
+
+	// same depth range as the static map, all receivers in the maze are covered
+	dynamic_map.projection = glm::ortho(center.x - half, center.x + half, center.y - half, center.y + half, 0.0f, depth_range);
+}
+
+void SunShadows::draw(const Map& map, const std::vector<Mesh*>& meshes, ShaderProgram& depth_shader)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, map.framebuffer);
+	glViewport(0, 0, map.size, map.size);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	depth_shader.activate();
+	depth_shader.setUniform("uPm", map.projection);
+	depth_shader.setUniform("uVm", light_view);
+	for (const Mesh* m : meshes)
+		if (!m->transparent)
+			m->drawDepth();
+}
+
+void SunShadows::render(ShaderProgram& depth_shader, StreamBuffer& stream)
+{
+	fit_dynamic();
+
+	// may be rendering offscreen (dynamic resolution), put everything back afterwards
+	GLint viewport[4], target = 0;
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f); // against shadow acne
+
+	if (static_dirty) {
+		draw(static_map, static_meshes, depth_shader);
+		static_dirty = false;
+		static_render_count++;
+	}
+	draw(dynamic_map, dynamic_meshes, depth_shader);
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+	StreamBuffer::Allocation a = stream.allocate(sizeof(GpuShadows));
+	GpuShadows* data = static_cast<GpuShadows*>(a.data);
+	data->static_matrix = bias_matrix * static_map.projection * light_view;
+	data->dynamic_matrix = bias_matrix * dynamic_map.projection * light_view;
+	stream.commit(a);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, matrix_binding, stream.id(), a.offset, a.size);
+}
+
+void SunShadows::clear(void)
+{
+	for (Map* map : { &static_map, &dynamic_map }) {
+		if (map->texture != 0)
+			GLState::deleteTextures(1, &map->texture);
+		if (map->framebuffer != 0)
+			glDeleteFramebuffers(1, &map->framebuffer);
+		map->texture = map->framebuffer = 0;
+	}
+	static_meshes.clear();
+	dynamic_meshes.clear();
+	dynamic_spheres.clear();
+}
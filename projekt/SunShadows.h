@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "StreamBuffer.h"
+
+// Directional shadow maps for the sun, split into a cached static map and a small dynamic one
+//
+// The static map covers the whole maze and is rendered only after invalidate(),
+// i.e. when the static geometry changes. The dynamic map is fitted every frame
+// around the moving objects only, so its cost does not depend on the maze size.
+// obj.frag takes the darker of both. Both use the depth pre-pass shader with the
+// light's matrices; the matrices reach the shaders through the frame StreamBuffer.
+class SunShadows {
+public:
+	static constexpr GLuint matrix_binding = 6;
+	static constexpr GLenum static_unit = GL_TEXTURE3;
+	static constexpr GLenum dynamic_unit = GL_TEXTURE4;
+
+	SunShadows(void) = default;
+	SunShadows(const SunShadows&) = delete;
+
+	void init(int static_size = 2048, int dynamic_size = 512); // needs GL context
+	// casters; meshes must stay at the same address
+	void set_static(const std::vector<Mesh*>& meshes);
+	void set_dynamic(const std::vector<Mesh*>& meshes);
+	// static geometry changed, re-render the cached map on the next render()
+	void invalidate(void) { static_dirty = true; }
+
+	// after ObjectBuffer::update(): renders the maps that need it and binds the matrices
+	void render(ShaderProgram& depth_shader, StreamBuffer& stream);
+	void clear(void); // needs current GL context
+
+	std::size_t bytes_per_frame(void) const { return sizeof(GpuShadows) + 256; }
+	GLuint static_texture(void) const { return static_map.texture; }
+	GLuint dynamic_texture(void) const { return dynamic_map.texture; }
+	unsigned int static_renders(void) const { return static_render_count; }
+	unsigned int dynamic_casters(void) const { return static_cast<unsigned int>(dynamic_meshes.size()); }
+
+private:
+	// std430 layout, must match obj.vert
+	struct GpuShadows {
+		glm::mat4 static_matrix;    // world -> [0,1] shadow map coordinates
+		glm::mat4 dynamic_matrix;
+	};
+
+	struct Map {
+		GLuint texture = 0;
+		GLuint framebuffer = 0;
+		int size = 0;
+		glm::mat4 projection = glm::mat4(1.0f);
+	};
+
+	void create(Map& map, int size);
+	void draw(const Map& map, const std::vector<Mesh*>& meshes, ShaderProgram& depth_shader);
+	void fit_dynamic(void);
+
+	Map static_map;
+	Map dynamic_map;
+	glm::mat4 light_view = glm::mat4(1.0f); // shared by both maps
+	float depth_range = 1.0f;
+
+	std::vector<Mesh*> static_meshes;
+	std::vector<Mesh*> dynamic_meshes;
+	std::vector<glm::vec4> dynamic_spheres; // local space
+
+	bool static_dirty = true;
+	unsigned int static_render_count = 0;
+};
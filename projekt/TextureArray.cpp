@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "TextureArray.h"
+#include "GLState.h"
+#include "stb_image.h"
+
+namespace {
+	// BC1 level to RGB8, for resampling on the CPU
+	std::vector<std::uint8_t> decode_bc1(const std::uint8_t* data, unsigned int width, unsigned int height)
+	{
+		std::vector<std::uint8_t> rgb(static_cast<std::size_t>(width) * height * 3);
+		const unsigned int blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+		for (unsigned int by = 0; by < blocks_y; ++by) {
+			for (unsigned int bx = 0; bx < blocks_x; ++bx) {
+				const std::uint8_t* block = data + (static_cast<std::size_t>(by) * blocks_x + bx) * 8;
+				unsigned int c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+				int palette[4][3];
+				for (int i = 0; i < 2; ++i) {
+					unsigned int c = i ? c1 : c0;
+					palette[i][0] = ((c >> 11) & 31) * 255 / 31;
+					palette[i][1] = ((c >> 5) & 63) * 255 / 63;
+					palette[i][2] = (c & 31) * 255 / 31;
+				}
+				for (int k = 0; k < 3; ++k) {
+					if (c0 > c1) {
+						palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+						palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+					}
+					else {
+						palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+						palette[3][k] = 0;
+					}
+				}
+				std::uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<std::uint32_t>(block[7]) << 24);
+				for (unsigned int i = 0; i < 16; ++i) {
+					unsigned int x = bx * 4 + i % 4, y = by * 4 + i / 4;
+					if (x >= width || y >= height)
+						continue;
+					const int* color = palette[(indices >> (2 * i)) & 3];
+					for (int k = 0; k < 3; ++k)
+						rgb[(static_cast<std::size_t>(y) * width + x) * 3 + k] = static_cast<std::uint8_t>(color[k]);
+				}
+			}
+		}
+		return rgb;
+	}
+
+	// bilinear resample of RGB8 to size x size
+	std::vector<std::uint8_t> resample(const std::vector<std::uint8_t>& src, unsigned int src_w, unsigned int src_h, unsigned int size)
+	{
+		std::vector<std::uint8_t> dst(static_cast<std::size_t>(size) * size * 3);
+		for (unsigned int y = 0; y < size; ++y) {
+			float fy = std::max(0.0f, (y + 0.5f) * src_h / size - 0.5f);
+			unsigned int y0 = std::min(static_cast<unsigned int>(fy), src_h - 1);
+			unsigned int y1 = std::min(y0 + 1, src_h - 1);
+			float ty = fy - y0;
+			for (unsigned int x = 0; x < size; ++x) {
+				float fx = std::max(0.0f, (x + 0.5f) * src_w / size - 0.5f);
+				unsigned int x0 = std::min(static_cast<unsigned int>(fx), src_w - 1);
+				unsigned int x1 = std::min(x0 + 1, src_w - 1);
+				float tx = fx - x0;
+				for (unsigned int c = 0; c < 3; ++c) {
+					float a = src[(static_cast<std::size_t>(y0) * src_w + x0) * 3 + c];
+					float b = src[(static_cast<std::size_t>(y0) * src_w + x1) * 3 + c];
+					float d = src[(static_cast<std::size_t>(y1) * src_w + x0) * 3 + c];
+					float e = src[(static_cast<std::size_t>(y1) * src_w + x1) * 3 + c];
+					float v = (a * (1 - tx) + b * tx) * (1 - ty) + (d * (1 - tx) + e * tx) * ty;
+					dst[(static_cast<std::size_t>(y) * size + x) * 3 + c] = static_cast<std::uint8_t>(std::lround(v));
+				}
+			}
+		}
+		return dst;
+	}
+}
+
+TextureArray::~TextureArray()
+{
+	if (texture != 0)
+		std::cerr << "TextureArray: texture not released.\n";
+}
+
+int TextureArray::add(const std::filesystem::path& source)
+{
+	std::string key = source.lexically_normal().generic_string();
+	auto found = by_path.find(key);
+	if (found != by_path.end())
+		return found->second;
+
+	// alpha textures need clamping and blending, keep them separate; checked before anything is cooked
+	int w, h, n;
+	if (!stbi_info(source.string().c_str(), &w, &h, &n) || n != 3)
+		return -1;
+
+	std::unique_ptr<CookedTexture> cooked;
+	try {
+		// the same BC1 container the single textures use
+		cooked = cache.open(source, TextureCompression::bc1);
+	}
+	catch (std::exception const& e) {
+		std::cout << e.what() << std::endl;
+		return -1;
+	}
+
+	// mip chain of the layer; each level from the smallest cooked level still at least that size
+	std::vector<std::vector<std::uint8_t>> chain;
+	for (unsigned int size = layer_size; ; size /= 2) {
+		unsigned int lvl = 0;
+		while (lvl + 1 < cooked->level_count() && cooked->level(lvl + 1).width >= size && cooked->level(lvl + 1).height >= size)
+			lvl++;
+
+		const TexcLevel& level = cooked->level(lvl);
+		const std::uint8_t* data = cooked->level_data(lvl);
+		if (level.width == size && level.height == size)
+			chain.emplace_back(data, data + level.size);
+		else
+			chain.push_back(compress_texture(resample(decode_bc1(data, level.width, level.height), level.width, level.height, size).data(),
+				size, size, 3, TextureCompression::bc1));
+		if (size == 1)
+			break;
+	}
+
+	int index = static_cast<int>(layers.size());
+	layers.push_back(std::move(chain));
+	by_path[key] = index;
+	return index;
+}
+
+GLuint TextureArray::build(void)
+{
+	if (layers.empty())
+		return 0;
+
+	const GLsizei levels = static_cast<GLsizei>(layers[0].size());
+
+	glGenTextures(1, &texture);
+	GLState::bindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, layer_size, layer_size, static_cast<GLsizei>(layers.size()));
+	layer_bytes = 0;
+	for (GLsizei l = 0; l < levels; ++l) {
+		GLsizei size = std::max(static_cast<GLsizei>(layer_size) >> l, 1);
+		for (size_t i = 0; i < layers.size(); ++i)
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, static_cast<GLint>(i), size, size, 1, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+				static_cast<GLsizei>(layers[i][l].size()), layers[i][l].data());
+		layer_bytes += layers[0][l].size();
+	}
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	std::cout << "Texture array: " << layers.size() << " BC1 layers of " << layer_size << 'x' << layer_size << std::endl;
+
+	// pixels live on the GPU now, keep only the layer count
+	for (auto& l : layers) {
+		l.clear();
+		l.shrink_to_fit();
+	}
+	return texture;
+}
+
+void TextureArray::clear(void)
+{
+	if (texture != 0)
+		GLState::deleteTextures(1, &texture);
+	texture = 0;
+	layers.clear();
+	by_path.clear();
+}
+
+std::size_t TextureArray::byte_cost(void) const
+{
+	return texture == 0 ? 0 : layer_bytes * layers.size();
+}
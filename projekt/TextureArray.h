@@ -0,0 +1,42 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TextureCache.h"
+
+// Texture atlas as GL_TEXTURE_2D_ARRAY
+//
+// Compatible (opaque, repeating) textures are resampled to a common layer size and
+// packed into layers of one BC1 array texture, so meshes using different materials
+// can be drawn without rebinding textures. Meshes keep only the layer index.
+// Mip levels of the cooked BC1 container that already have the layer's size are
+// copied as they are, only the others are decoded, resampled and encoded again.
+class TextureArray {
+public:
+	explicit TextureArray(TextureCache& cache, unsigned int layer_size = 1024) : cache(cache), layer_size(layer_size) {}
+	TextureArray(const TextureArray&) = delete;
+	~TextureArray();
+
+	// returns layer index, or -1 if the texture can not be packed (has alpha, failed to load)
+	int add(const std::filesystem::path& source);
+
+	// upload all added layers, creates the GL texture; call once after all add()
+	GLuint build(void);
+	void clear(void); // needs current GL context
+
+	GLuint id(void) const { return texture; }
+	unsigned int layer_count(void) const { return static_cast<unsigned int>(layers.size()); }
+	std::size_t byte_cost(void) const;
+
+private:
+	TextureCache& cache;
+	unsigned int layer_size;
+	GLuint texture = 0;
+
+	std::unordered_map<std::string, int> by_path;
+	std::vector<std::vector<std::vector<std::uint8_t>>> layers; // BC1 mip chain per layer, layer_size^2 down to 1x1
+	std::size_t layer_bytes = 0; // one chain, kept after build() releases the data
+};
@@ -0,0 +1,539 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "TextureCache.h"
+#include "GLState.h"
+#include "stb_image.h"
+
+static constexpr char texc_magic[4] = { 'T', 'E', 'X', 'C' };
+static constexpr std::uint32_t texc_version = 1;
+
+//
+// MappedFile
+//
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(file);
+		return;
+	}
+
+	ptr = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (ptr == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return;
+	}
+
+	length = static_cast<std::size_t>(file_size.QuadPart);
+	file_handle = file;
+	mapping_handle = mapping;
+}
+
+MappedFile::~MappedFile()
+{
+	if (ptr)
+		UnmapViewOfFile(ptr);
+	if (mapping_handle)
+		CloseHandle(mapping_handle);
+	if (file_handle)
+		CloseHandle(file_handle);
+}
+#else
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			ptr = static_cast<const std::uint8_t*>(p);
+			length = static_cast<std::size_t>(st.st_size);
+		}
+	}
+	::close(fd); // mapping stays valid
+}
+
+MappedFile::~MappedFile()
+{
+	if (ptr)
+		munmap(const_cast<std::uint8_t*>(ptr), length);
+}
+#endif
+
+//
+// CPU image processing
+//
+
+namespace {
+	struct Image {
+		unsigned int width = 0;
+		unsigned int height = 0;
+		unsigned int channels = 0;
+		std::vector<std::uint8_t> pixels;
+	};
+
+	// 2x2 box filter, odd edges are clamped
+	Image downsample(const Image& src)
+	{
+		Image dst;
+		dst.width = std::max(1u, src.width / 2);
+		dst.height = std::max(1u, src.height / 2);
+		dst.channels = src.channels;
+		dst.pixels.resize(static_cast<std::size_t>(dst.width) * dst.height * dst.channels);
+
+		for (unsigned int y = 0; y < dst.height; ++y) {
+			unsigned int y0 = std::min(2 * y, src.height - 1);
+			unsigned int y1 = std::min(2 * y + 1, src.height - 1);
+			for (unsigned int x = 0; x < dst.width; ++x) {
+				unsigned int x0 = std::min(2 * x, src.width - 1);
+				unsigned int x1 = std::min(2 * x + 1, src.width - 1);
+				for (unsigned int c = 0; c < src.channels; ++c) {
+					unsigned int sum =
+						src.pixels[(static_cast<std::size_t>(y0) * src.width + x0) * src.channels + c] +
+						src.pixels[(static_cast<std::size_t>(y0) * src.width + x1) * src.channels + c] +
+						src.pixels[(static_cast<std::size_t>(y1) * src.width + x0) * src.channels + c] +
+						src.pixels[(static_cast<std::size_t>(y1) * src.width + x1) * src.channels + c];
+					dst.pixels[(static_cast<std::size_t>(y) * dst.width + x) * dst.channels + c] = static_cast<std::uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		return dst;
+	}
+
+	//
+	// BC1 / BC3 block encoders (bounding box fit with inset, nearest index)
+	//
+
+	std::uint16_t to_565(const std::uint8_t* rgb)
+	{
+		return static_cast<std::uint16_t>(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+	}
+
+	void from_565(std::uint16_t c, int* rgb)
+	{
+		int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	// block = 16 RGBA pixels, writes 8 bytes
+	void encode_bc1_block(const std::uint8_t block[16][4], std::uint8_t* out)
+	{
+		std::uint8_t lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; ++i) {
+			for (int c = 0; c < 3; ++c) {
+				lo[c] = std::min(lo[c], block[i][c]);
+				hi[c] = std::max(hi[c], block[i][c]);
+			}
+		}
+		// inset the box by 1/16 of its size to reduce error at the extremes
+		for (int c = 0; c < 3; ++c) {
+			int inset = (hi[c] - lo[c]) >> 4;
+			lo[c] = static_cast<std::uint8_t>(lo[c] + inset);
+			hi[c] = static_cast<std::uint8_t>(hi[c] - inset);
+		}
+
+		std::uint16_t c0 = to_565(hi), c1 = to_565(lo);
+		if (c0 < c1)
+			std::swap(c0, c1); // c0 > c1 selects 4-color mode
+
+		std::uint32_t indices = 0;
+		if (c0 != c1) {
+			int palette[4][3];
+			from_565(c0, palette[0]);
+			from_565(c1, palette[1]);
+			for (int c = 0; c < 3; ++c) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (int i = 0; i < 16; ++i) {
+				int best = 0, best_dist = INT_MAX;
+				for (int p = 0; p < 4; ++p) {
+					int dr = block[i][0] - palette[p][0];
+					int dg = block[i][1] - palette[p][1];
+					int db = block[i][2] - palette[p][2];
+					int dist = dr * dr + dg * dg + db * db;
+					if (dist < best_dist) {
+						best_dist = dist;
+						best = p;
+					}
+				}
+				indices |= static_cast<std::uint32_t>(best) << (2 * i);
+			}
+		}
+
+		out[0] = static_cast<std::uint8_t>(c0 & 0xff);
+		out[1] = static_cast<std::uint8_t>(c0 >> 8);
+		out[2] = static_cast<std::uint8_t>(c1 & 0xff);
+		out[3] = static_cast<std::uint8_t>(c1 >> 8);
+		std::memcpy(out + 4, &indices, 4);
+	}
+
+	// alpha part of BC3, writes 8 bytes
+	void encode_bc3_alpha_block(const std::uint8_t block[16][4], std::uint8_t* out)
+	{
+		std::uint8_t a0 = 0, a1 = 255;
+		for (int i = 0; i < 16; ++i) {
+			a0 = std::max(a0, block[i][3]);
+			a1 = std::min(a1, block[i][3]);
+		}
+
+		std::uint64_t indices = 0;
+		if (a0 != a1) {
+			// a0 > a1 selects the 8 value interpolation mode
+			int palette[8] = { a0, a1 };
+			for (int p = 1; p < 7; ++p)
+				palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+			for (int i = 0; i < 16; ++i) {
+				int best = 0, best_dist = INT_MAX;
+				for (int p = 0; p < 8; ++p) {
+					int dist = std::abs(block[i][3] - palette[p]);
+					if (dist < best_dist) {
+						best_dist = dist;
+						best = p;
+					}
+				}
+				indices |= static_cast<std::uint64_t>(best) << (3 * i);
+			}
+		}
+
+		out[0] = a0;
+		out[1] = a1;
+		for (int b = 0; b < 6; ++b)
+			out[2 + b] = static_cast<std::uint8_t>((indices >> (8 * b)) & 0xff);
+	}
+
+	std::vector<std::uint8_t> compress(const Image& img, TextureCompression compression)
+	{
+		const unsigned int blocks_x = (img.width + 3) / 4;
+		const unsigned int blocks_y = (img.height + 3) / 4;
+		const std::size_t block_bytes = compression == TextureCompression::bc3 ? 16 : 8;
+		std::vector<std::uint8_t> out(static_cast<std::size_t>(blocks_x) * blocks_y * block_bytes);
+
+		std::uint8_t block[16][4];
+		for (unsigned int by = 0; by < blocks_y; ++by) {
+			for (unsigned int bx = 0; bx < blocks_x; ++bx) {
+				// gather 4x4 texels, clamp at the edges, expand to RGBA
+				for (unsigned int py = 0; py < 4; ++py) {
+					unsigned int y = std::min(by * 4 + py, img.height - 1);
+					for (unsigned int px = 0; px < 4; ++px) {
+						unsigned int x = std::min(bx * 4 + px, img.width - 1);
+						const std::uint8_t* src = &img.pixels[(static_cast<std::size_t>(y) * img.width + x) * img.channels];
+						std::uint8_t* dst = block[py * 4 + px];
+						dst[0] = src[0];
+						dst[1] = img.channels >= 3 ? src[1] : src[0];
+						dst[2] = img.channels >= 3 ? src[2] : src[0];
+						dst[3] = img.channels == 4 ? src[3] : 255;
+					}
+				}
+
+				std::uint8_t* dst = &out[(static_cast<std::size_t>(by) * blocks_x + bx) * block_bytes];
+				if (compression == TextureCompression::bc3) {
+					encode_bc3_alpha_block(block, dst);
+					encode_bc1_block(block, dst + 8);
+				}
+				else {
+					encode_bc1_block(block, dst);
+				}
+			}
+		}
+		return out;
+	}
+
+	std::int64_t mtime_of(const std::filesystem::path& path)
+	{
+		return static_cast<std::int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+	}
+
+	// peek channel count without decoding, 0 on failure
+	int source_channels(const std::filesystem::path& source)
+	{
+		int w, h, n;
+		if (!stbi_info(source.string().c_str(), &w, &h, &n))
+			return 0;
+		return n;
+	}
+
+	TextureCompression resolve(TextureCompression compression, int channels)
+	{
+		if (compression != TextureCompression::automatic)
+			return compression;
+		if (channels == 4)
+			return TextureCompression::bc3;
+		if (channels == 3)
+			return TextureCompression::bc1;
+		return TextureCompression::none;
+	}
+}
+
+//
+// CookedTexture
+//
+
+CookedTexture::CookedTexture(const std::filesystem::path& container) : file(container)
+{
+	if (!file.is_open() || file.size() < sizeof(TexcHeader))
+		throw std::exception(std::string("Can not map texture container: ").append(container.string()).c_str());
+
+	hdr = reinterpret_cast<const TexcHeader*>(file.data());
+	if (std::memcmp(hdr->magic, texc_magic, 4) != 0 || hdr->version != texc_version || hdr->levels == 0)
+		throw std::exception(std::string("Unknown texture container: ").append(container.string()).c_str());
+
+	if (file.size() < sizeof(TexcHeader) + hdr->levels * sizeof(TexcLevel))
+		throw std::exception(std::string("Truncated texture container: ").append(container.string()).c_str());
+
+	levels = reinterpret_cast<const TexcLevel*>(file.data() + sizeof(TexcHeader));
+	for (unsigned int i = 0; i < hdr->levels; ++i) {
+		if (levels[i].offset + levels[i].size > file.size())
+			throw std::exception(std::string("Truncated texture container: ").append(container.string()).c_str());
+	}
+}
+
+GLenum CookedTexture::internal_format(void) const
+{
+	switch (static_cast<TextureCompression>(hdr->compression)) {
+	case TextureCompression::bc1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case TextureCompression::bc3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default:
+		return pixel_format();
+	}
+}
+
+GLenum CookedTexture::pixel_format(void) const
+{
+	switch (hdr->channels) {
+	case 1:
+		return GL_RED;
+	case 2:
+		return GL_RG;
+	case 3:
+		return GL_RGB;
+	default:
+		return GL_RGBA;
+	}
+}
+
+std::size_t CookedTexture::byte_cost(unsigned int first_level) const
+{
+	std::size_t bytes = 0;
+	for (unsigned int i = first_level; i < hdr->levels; ++i)
+		bytes += static_cast<std::size_t>(levels[i].size);
+	return bytes;
+}
+
+void CookedTexture::upload(GLuint texture, unsigned int first_level) const
+{
+	first_level = std::min(first_level, hdr->levels - 1);
+
+	GLState::bindTexture(GL_TEXTURE_2D, texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // RGB rows of small mips are not 4-byte aligned
+
+	for (unsigned int i = first_level; i < hdr->levels; ++i) {
+		GLint gl_level = static_cast<GLint>(i - first_level);
+		if (is_compressed())
+			glCompressedTexImage2D(GL_TEXTURE_2D, gl_level, internal_format(), levels[i].width, levels[i].height, 0, static_cast<GLsizei>(levels[i].size), level_data(i));
+		else
+			glTexImage2D(GL_TEXTURE_2D, gl_level, internal_format(), levels[i].width, levels[i].height, 0, pixel_format(), GL_UNSIGNED_BYTE, level_data(i));
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(hdr->levels - 1 - first_level));
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, hdr->channels == 4 ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, hdr->channels == 4 ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+//
+// TextureCache
+//
+
+std::vector<std::uint8_t> compress_texture(const std::uint8_t* pixels, unsigned int width, unsigned int height, unsigned int channels,
+	TextureCompression compression)
+{
+	Image img;
+	img.width = width;
+	img.height = height;
+	img.channels = channels;
+	img.pixels.assign(pixels, pixels + static_cast<std::size_t>(width) * height * channels);
+	return compress(img, compression);
+}
+
+std::filesystem::path TextureCache::container_path(const std::filesystem::path& source, TextureCompression compression) const
+{
+	// flatten relative source path into a file name, e.g. resources_textures_box.png.bc1.texc
+	std::string name = source.lexically_normal().generic_string();
+	std::replace(name.begin(), name.end(), '/', '_');
+	std::replace(name.begin(), name.end(), ':', '_');
+
+	switch (compression) {
+	case TextureCompression::bc1:
+		name.append(".bc1");
+		break;
+	case TextureCompression::bc3:
+		name.append(".bc3");
+		break;
+	case TextureCompression::none:
+		name.append(".raw");
+		break;
+	default:
+		name.append(".auto");
+		break;
+	}
+	return cache_dir / name.append(".texc");
+}
+
+bool TextureCache::is_stale(const std::filesystem::path& source, TextureCompression compression) const
+{
+	// cook() passes a resolved compression, the source is only peeked for automatic
+	if (compression == TextureCompression::automatic)
+		compression = resolve(compression, source_channels(source));
+
+	auto container = container_path(source, compression);
+	std::error_code ec;
+	if (!std::filesystem::exists(container, ec))
+		return true;
+
+	TexcHeader hdr;
+	std::ifstream in(container, std::ios::binary);
+	if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)))
+		return true;
+
+	return std::memcmp(hdr.magic, texc_magic, 4) != 0 ||
+		hdr.version != texc_version ||
+		hdr.levels == 0 ||
+		hdr.source_size != std::filesystem::file_size(source) ||
+		hdr.source_mtime != mtime_of(source);
+}
+
+std::filesystem::path TextureCache::cook(const std::filesystem::path& source, TextureCompression compression, bool force)
+{
+	// one stbi_info at most, is_stale gets the resolved compression
+	if (compression == TextureCompression::automatic)
+		compression = resolve(compression, source_channels(source));
+	auto container = container_path(source, compression);
+	if (!force && !is_stale(source, compression))
+		return container;
+
+	int w, h, n;
+	std::uint8_t* data = stbi_load(source.string().c_str(), &w, &h, &n, 0);
+	if (!data)
+		throw std::exception(std::string("Texture failed to load at path: ").append(source.string()).c_str());
+
+	// full mip chain down to 1x1
+	std::vector<Image> chain(1);
+	chain[0].width = w;
+	chain[0].height = h;
+	chain[0].channels = n;
+	chain[0].pixels.assign(data, data + static_cast<std::size_t>(w) * h * n);
+	stbi_image_free(data);
+
+	while (chain.back().width > 1 || chain.back().height > 1)
+		chain.push_back(downsample(chain.back()));
+
+	std::vector<std::vector<std::uint8_t>> payload;
+	for (auto const& img : chain) {
+		if (compression == TextureCompression::none)
+			payload.push_back(img.pixels);
+		else
+			payload.push_back(compress(img, compression));
+	}
+
+	TexcHeader hdr{};
+	std::memcpy(hdr.magic, texc_magic, 4);
+	hdr.version = texc_version;
+	hdr.source_size = std::filesystem::file_size(source);
+	hdr.source_mtime = mtime_of(source);
+	hdr.width = w;
+	hdr.height = h;
+	hdr.channels = n;
+	hdr.compression = static_cast<std::uint32_t>(compression);
+	hdr.levels = static_cast<std::uint32_t>(chain.size());
+
+	std::vector<TexcLevel> table(chain.size());
+	std::uint64_t offset = sizeof(TexcHeader) + table.size() * sizeof(TexcLevel);
+	for (size_t i = 0; i < chain.size(); ++i) {
+		table[i] = { offset, payload[i].size(), chain[i].width, chain[i].height };
+		offset += payload[i].size();
+	}
+
+	std::filesystem::create_directories(container.parent_path());
+	// write to temp file first, so a crashed cook never leaves a valid-looking container
+	auto temp = container;
+	temp += ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		if (!out)
+			throw std::exception(std::string("Can not write texture container: ").append(temp.string()).c_str());
+		out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+		out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(TexcLevel));
+		for (auto const& p : payload)
+			out.write(reinterpret_cast<const char*>(p.data()), p.size());
+	}
+	std::filesystem::rename(temp, container);
+
+	std::cout << "Cooked " << source.generic_string() << " -> " << container.generic_string()
+		<< " (" << w << 'x' << h << ", " << chain.size() << " levels, " << offset / 1024 << " KiB)\n";
+
+	return container;
+}
+
+std::unique_ptr<CookedTexture> TextureCache::open(const std::filesystem::path& source, TextureCompression compression)
+{
+	return std::make_unique<CookedTexture>(cook(source, compression));
+}
+
+GLuint TextureCache::load(const std::filesystem::path& source, const TextureImportSettings& settings)
+{
+	std::unique_ptr<CookedTexture> cooked;
+	try {
+		cooked = open(source, settings.compression);
+	}
+	catch (std::exception const& e) {
+		std::cout << e.what() << std::endl;
+		return 0;
+	}
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	cooked->upload(textureID, settings.quality == TextureQuality::reduced ? 1 : 0);
+
+	return textureID;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+// OpenGL Extension Wrangler
+#include <GL/glew.h>
+#include <GL/wglew.h> //WGLEW = Windows GL Extension Wrangler (change for different platform)
+
+// Cooked texture container (*.texc)
+//
+// Source images (JPEG/PNG) are decoded by stb only once, the full mip chain is built
+// on the CPU, optionally block-compressed, and written into the cache directory.
+// Next runs memory-map the container and upload the levels directly.
+
+enum class TextureCompression : std::uint32_t {
+	none = 0,      // raw 8-bit channels, as decoded
+	bc1 = 1,       // DXT1, RGB, 4 bpp
+	bc3 = 3,       // DXT5, RGBA, 8 bpp
+	automatic = 255 // bc3 for RGBA sources, bc1 for RGB, none for single channel
+};
+
+enum class TextureQuality {
+	full,   // upload whole mip chain
+	reduced // skip the top level (half resolution, quarter memory)
+};
+
+struct TextureImportSettings {
+	TextureCompression compression = TextureCompression::automatic;
+	TextureQuality quality = TextureQuality::full;
+};
+
+// bc1 or bc3 blocks of one level of 8-bit pixels, the encoder used for cooking
+std::vector<std::uint8_t> compress_texture(const std::uint8_t* pixels, unsigned int width, unsigned int height, unsigned int channels,
+	TextureCompression compression);
+
+#pragma pack(push, 1)
+struct TexcHeader {
+	char magic[4];              // "TEXC"
+	std::uint32_t version;
+	std::uint64_t source_size;  // for invalidation
+	std::int64_t source_mtime;  // for invalidation
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t channels;     // of the source image
+	std::uint32_t compression;  // TextureCompression, never automatic
+	std::uint32_t levels;
+};
+
+struct TexcLevel {
+	std::uint64_t offset;       // from start of file
+	std::uint64_t size;         // bytes
+	std::uint32_t width;
+	std::uint32_t height;
+};
+#pragma pack(pop)
+
+// read-only memory mapping of a whole file
+class MappedFile {
+public:
+	MappedFile(void) = default;
+	explicit MappedFile(const std::filesystem::path& path);
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	const std::uint8_t* data(void) const { return ptr; }
+	std::size_t size(void) const { return length; }
+	bool is_open(void) const { return ptr != nullptr; }
+
+private:
+	const std::uint8_t* ptr = nullptr;
+	std::size_t length = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
+
+// a cooked container opened for reading; level data point into the mapping
+class CookedTexture {
+public:
+	explicit CookedTexture(const std::filesystem::path& container);
+
+	const TexcHeader& header(void) const { return *hdr; }
+	const TexcLevel& level(unsigned int i) const { return levels[i]; }
+	const std::uint8_t* level_data(unsigned int i) const { return file.data() + levels[i].offset; }
+	unsigned int level_count(void) const { return hdr->levels; }
+
+	// GL enums for upload
+	GLenum internal_format(void) const;
+	GLenum pixel_format(void) const;
+	bool is_compressed(void) const { return hdr->compression != static_cast<std::uint32_t>(TextureCompression::none); }
+
+	// bytes occupied on the GPU when uploaded from first_level down
+	std::size_t byte_cost(unsigned int first_level = 0) const;
+
+	// (re)specify texture storage from level first_level of the chain
+	void upload(GLuint texture, unsigned int first_level = 0) const;
+
+private:
+	MappedFile file;
+	const TexcHeader* hdr = nullptr;
+	const TexcLevel* levels = nullptr;
+};
+
+class TextureCache {
+public:
+	explicit TextureCache(const std::filesystem::path& cache_dir = "cache/textures") : cache_dir(cache_dir) {}
+
+	// container path for given source, does not touch the filesystem
+	std::filesystem::path container_path(const std::filesystem::path& source, TextureCompression compression) const;
+
+	// true if the container is missing, unreadable or older than source
+	bool is_stale(const std::filesystem::path& source, TextureCompression compression) const;
+
+	// decode, build mips, compress, write container (only if stale); returns container path
+	std::filesystem::path cook(const std::filesystem::path& source, TextureCompression compression, bool force = false);
+
+	// cook on first use and open the container
+	std::unique_ptr<CookedTexture> open(const std::filesystem::path& source, TextureCompression compression);
+
+	// cook if needed, create a GL texture and upload; returns 0 on failure
+	GLuint load(const std::filesystem::path& source, const TextureImportSettings& settings = {});
+
+private:
+	std::filesystem::path cache_dir;
+};
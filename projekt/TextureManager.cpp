@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include "TextureManager.h"
+#include "GLState.h"
+
+TextureManager::~TextureManager()
+{
+	// GL context is gone at this point, clear() must be called before glfwTerminate()
+	if (!entries.empty())
+		std::cerr << "TextureManager: " << entries.size() << " textures not released.\n";
+}
+
+GLuint TextureManager::acquire(const std::filesystem::path& source, const TextureImportSettings& settings)
+{
+	std::string key = source.lexically_normal().generic_string()
+		.append("|").append(std::to_string(static_cast<std::uint32_t>(settings.compression)))
+		.append("|").append(std::to_string(static_cast<int>(settings.quality)));
+
+	auto found = by_key.find(key);
+	if (found != by_key.end()) {
+		entries[found->second].refcount++;
+		return found->second;
+	}
+
+	Entry e;
+	try {
+		e.source = cache.open(source, settings.compression);
+	}
+	catch (std::exception const& ex) {
+		std::cout << ex.what() << std::endl;
+		return 0;
+	}
+
+	GLuint texture;
+	glGenTextures(1, &texture);
+
+	e.key = key;
+	e.refcount = 1;
+	e.base_level = std::min(settings.quality == TextureQuality::reduced ? 1u : 0u, e.source->level_count() - 1);
+	e.first_level = e.base_level;
+	e.bytes = e.source->byte_cost(e.first_level);
+	e.last_visible = frame;
+	e.source->upload(texture, e.first_level);
+
+	total_bytes += e.bytes;
+	by_key[key] = texture;
+	entries.emplace(texture, std::move(e));
+
+	return texture;
+}
+
+void TextureManager::release(GLuint texture)
+{
+	auto it = entries.find(texture);
+	if (it == entries.end())
+		return;
+
+	if (--it->second.refcount == 0) {
+		total_bytes -= it->second.bytes;
+		by_key.erase(it->second.key);
+		entries.erase(it);
+		GLState::deleteTextures(1, &texture);
+	}
+}
+
+void TextureManager::clear(void)
+{
+	for (auto const& [texture, e] : entries)
+		GLState::deleteTextures(1, &texture);
+
+	entries.clear();
+	by_key.clear();
+	total_bytes = 0;
+}
+
+void TextureManager::mark_visible(GLuint texture, float distance)
+{
+	auto it = entries.find(texture);
+	if (it == entries.end())
+		return;
+
+	Entry& e = it->second;
+	if (e.last_visible != frame) {
+		e.last_visible = frame;
+		e.distance = distance;
+	}
+	else {
+		e.distance = std::min(e.distance, distance);
+	}
+}
+
+unsigned int TextureManager::dropped_levels(void) const
+{
+	unsigned int dropped = 0;
+	for (auto const& [texture, e] : entries)
+		dropped += e.first_level - e.base_level;
+	return dropped;
+}
+
+void TextureManager::set_first_level(GLuint texture, Entry& e, unsigned int level)
+{
+	total_bytes -= e.bytes;
+	e.first_level = level;
+	e.bytes = e.source->byte_cost(level);
+	total_bytes += e.bytes;
+
+	e.source->upload(texture, level);
+}
+
+void TextureManager::update(void)
+{
+	unsigned int uploads = 0;
+
+	// over budget: drop one top level at a time, least recently visible (then farthest) first
+	while (total_bytes > vram_budget && uploads < max_uploads_per_frame) {
+		GLuint victim = 0;
+		Entry* victim_entry = nullptr;
+		for (auto& [texture, e] : entries) {
+			unsigned int next = e.first_level + 1;
+			if (next >= e.source->level_count())
+				continue;
+			auto const& lvl = e.source->level(next);
+			if (std::max(lvl.width, lvl.height) < min_resident_size)
+				continue;
+
+			if (!victim_entry ||
+				e.last_visible < victim_entry->last_visible ||
+				(e.last_visible == victim_entry->last_visible && e.distance > victim_entry->distance)) {
+				victim = texture;
+				victim_entry = &e;
+			}
+		}
+		if (!victim_entry)
+			break; // nothing left to drop
+
+		set_first_level(victim, *victim_entry, victim_entry->first_level + 1);
+		uploads++;
+	}
+
+	// spare budget: bring levels back to visible textures, closest first
+	while (uploads < max_uploads_per_frame) {
+		GLuint candidate = 0;
+		Entry* candidate_entry = nullptr;
+		for (auto& [texture, e] : entries) {
+			if (e.first_level == e.base_level || e.last_visible != frame || e.distance > restore_distance)
+				continue;
+			if (total_bytes - e.bytes + e.source->byte_cost(e.first_level - 1) > vram_budget)
+				continue;
+			if (!candidate_entry || e.distance < candidate_entry->distance) {
+				candidate = texture;
+				candidate_entry = &e;
+			}
+		}
+		if (!candidate_entry)
+			break;
+
+		set_first_level(candidate, *candidate_entry, candidate_entry->first_level - 1);
+		uploads++;
+	}
+
+	frame++;
+}
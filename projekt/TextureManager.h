@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "TextureCache.h"
+
+// Owner of all GL textures of the scene
+//
+// Textures are deduplicated by (path, import settings) and reference counted.
+// Every texture knows its byte cost; when the sum exceeds the VRAM budget, top mip
+// levels of the least recently visible textures are dropped. Dropped levels are
+// re-uploaded from the cooked container when the texture is visible and close again.
+class TextureManager {
+public:
+	explicit TextureManager(TextureCache& cache, std::size_t vram_budget = 256 * 1024 * 1024) : cache(cache), vram_budget(vram_budget) {}
+	TextureManager(const TextureManager&) = delete;
+	~TextureManager();
+
+	// returns existing texture for the same path and settings, or loads a new one; 0 on failure
+	GLuint acquire(const std::filesystem::path& source, const TextureImportSettings& settings = {});
+	void release(GLuint texture);
+	void clear(void); // delete all textures, needs current GL context
+
+	// call for every texture used in a frame, distance from camera to the object
+	void mark_visible(GLuint texture, float distance);
+	// end of frame: drop or restore mip levels to honour the budget
+	void update(void);
+
+	void set_budget(std::size_t bytes) { vram_budget = bytes; }
+	std::size_t budget(void) const { return vram_budget; }
+	std::size_t bytes_used(void) const { return total_bytes; }
+	std::size_t texture_count(void) const { return entries.size(); }
+	unsigned int dropped_levels(void) const;
+
+	// objects closer than this get their full mip chain back first
+	float restore_distance = 10.0f;
+	// smallest top level kept when dropping, in texels
+	unsigned int min_resident_size = 64;
+	// limit re-uploads to avoid frame hitches
+	unsigned int max_uploads_per_frame = 1;
+
+private:
+	struct Entry {
+		std::string key;
+		std::unique_ptr<CookedTexture> source;
+		unsigned int refcount = 0;
+		unsigned int base_level = 0;    // first level allowed by import settings
+		unsigned int first_level = 0;   // currently uploaded top level
+		std::size_t bytes = 0;
+		std::uint64_t last_visible = 0; // frame number
+		float distance = 0.0f;          // closest distance in last visible frame
+	};
+
+	void set_first_level(GLuint texture, Entry& e, unsigned int level);
+
+	TextureCache& cache;
+	std::size_t vram_budget;
+	std::size_t total_bytes = 0;
+	std::uint64_t frame = 1;
+
+	std::unordered_map<std::string, GLuint> by_key;
+	std::unordered_map<GLuint, Entry> entries;
+};
@@ -0,0 +1,75 @@
+#include "TransformSystem.h"
+
+TransformSystem::Node TransformSystem::create(Node parent_node)
+{
+	if (parent_node != none && parent_node >= parent.size())
+		throw std::exception("TransformSystem: parent does not exist");
+
+	Node n = static_cast<Node>(parent.size());
+	local_position.push_back(glm::vec3(0.0f));
+	local_rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	local_scale.push_back(glm::vec3(1.0f));
+	parent.push_back(parent_node);
+	local_matrix.push_back(glm::mat4(1.0f));
+	world_matrix.push_back(glm::mat4(1.0f));
+	dirty.push_back(1);
+	changed_flag.push_back(0);
+	return n;
+}
+
+void TransformSystem::clear(void)
+{
+	local_position.clear();
+	local_rotation.clear();
+	local_scale.clear();
+	parent.clear();
+	local_matrix.clear();
+	world_matrix.clear();
+	dirty.clear();
+	changed_flag.clear();
+	work.clear();
+	last_stats = Stats();
+}
+
+void TransformSystem::set_local(Node n, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+{
+	local_position[n] = position;
+	local_rotation[n] = rotation;
+	local_scale[n] = scale;
+	dirty[n] = 1;
+}
+
+void TransformSystem::update(void)
+{
+	// collect: parents come first, so their changed flag is final when a child is visited
+	work.clear();
+	const std::size_t count = parent.size();
+	for (std::size_t i = 0; i < count; ++i) {
+		Node p = parent[i];
+		std::uint8_t c = dirty[i] | ((p != none) ? changed_flag[p] : std::uint8_t(0));
+		changed_flag[i] = c;
+		dirty[i] = 0;
+		if (c)
+			work.push_back(static_cast<Node>(i));
+	}
+
+	// batch 1: local T * R * S, rotation columns scaled, no dependencies between nodes
+	for (Node n : work) {
+		glm::mat3 r = glm::mat3_cast(local_rotation[n]);
+		const glm::vec3& s = local_scale[n];
+		glm::mat4& m = local_matrix[n];
+		m[0] = glm::vec4(r[0] * s.x, 0.0f);
+		m[1] = glm::vec4(r[1] * s.y, 0.0f);
+		m[2] = glm::vec4(r[2] * s.z, 0.0f);
+		m[3] = glm::vec4(local_position[n], 1.0f);
+	}
+
+	// batch 2: world = parent world * local, in order
+	for (Node n : work) {
+		Node p = parent[n];
+		world_matrix[n] = (p != none) ? world_matrix[p] * local_matrix[n] : local_matrix[n];
+	}
+
+	last_stats.nodes = static_cast<unsigned int>(count);
+	last_stats.updated = static_cast<unsigned int>(work.size());
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Hierarchical transforms with dirty flags
+//
+// Nodes hold a local translation, rotation and scale and an optional parent.
+// Parents always precede their children in the packed arrays, so update() is a
+// single forward pass: a node is recomputed when it was changed or its parent's
+// world matrix was, everything else (the static maze) is skipped. The nodes to
+// recompute are collected first and processed in two branch-free batches, local
+// matrices and then parent * local, over contiguous arrays.
+class TransformSystem {
+public:
+	using Node = std::uint32_t;
+	static constexpr Node none = 0xFFFFFFFFu;
+
+	struct Stats {
+		unsigned int nodes = 0;
+		unsigned int updated = 0; // world matrices recomputed in the last update()
+	};
+
+	TransformSystem(void) = default;
+	TransformSystem(const TransformSystem&) = delete;
+
+	// parent must already exist, that keeps the parents-first order
+	Node create(Node parent = none);
+	void clear(void);
+
+	void set_local(Node n, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+	void set_position(Node n, const glm::vec3& position) { local_position[n] = position; dirty[n] = 1; }
+	void set_rotation(Node n, const glm::quat& rotation) { local_rotation[n] = rotation; dirty[n] = 1; }
+
+	// recompute dirty nodes and their descendants
+	void update(void);
+
+	const glm::mat4& world(Node n) const { return world_matrix[n]; }
+	glm::vec3 world_position(Node n) const { return glm::vec3(world_matrix[n][3]); }
+	// world matrix was recomputed by the last update()
+	bool changed(Node n) const { return changed_flag[n] != 0; }
+
+	const Stats& stats(void) const { return last_stats; }
+
+private:
+	std::vector<glm::vec3> local_position;
+	std::vector<glm::quat> local_rotation;
+	std::vector<glm::vec3> local_scale;
+	std::vector<Node> parent;
+	std::vector<glm::mat4> local_matrix;
+	std::vector<glm::mat4> world_matrix;
+	std::vector<std::uint8_t> dirty;
+	std::vector<std::uint8_t> changed_flag;
+
+	std::vector<Node> work; // nodes to recompute, in parents-first order
+	Stats last_stats;
+};
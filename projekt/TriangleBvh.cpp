@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <numeric>
+
+#include "TriangleBvh.h"
+
+void TriangleBvh::build(const std::vector<glm::vec3>& vertices)
+{
+	triangles = vertices;
+	std::uint32_t count = static_cast<std::uint32_t>(triangles.size() / 3);
+
+	order.resize(count);
+	std::iota(order.begin(), order.end(), 0);
+	centroids.resize(count);
+	for (std::uint32_t i = 0; i < count; ++i)
+		centroids[i] = (triangles[3 * i] + triangles[3 * i + 1] + triangles[3 * i + 2]) / 3.0f;
+
+	nodes.clear();
+	nodes.reserve(count > 0 ? 2 * count : 1);
+	if (count > 0)
+		build_node(0, count);
+	centroids.clear();
+	centroids.shrink_to_fit();
+}
+
+std::uint32_t TriangleBvh::build_node(std::uint32_t first, std::uint32_t count)
+{
+	std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+	nodes.emplace_back();
+
+	glm::vec3 lo(1e30f), hi(-1e30f), clo(1e30f), chi(-1e30f);
+	for (std::uint32_t i = first; i < first + count; ++i) {
+		std::uint32_t tri = order[i];
+		for (int v = 0; v < 3; ++v) {
+			lo = glm::min(lo, triangles[3 * tri + v]);
+			hi = glm::max(hi, triangles[3 * tri + v]);
+		}
+		clo = glm::min(clo, centroids[tri]);
+		chi = glm::max(chi, centroids[tri]);
+	}
+	nodes[index].lo = lo;
+	nodes[index].hi = hi;
+
+	glm::vec3 extent = chi - clo;
+	if (count <= max_leaf_size || glm::max(extent.x, glm::max(extent.y, extent.z)) <= 0.0f) {
+		nodes[index].right_or_first = first;
+		nodes[index].count = count;
+		return index;
+	}
+
+	int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+	std::uint32_t half = count / 2;
+	std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+		[&](std::uint32_t a, std::uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+
+	build_node(first, half); // left child follows directly
+	std::uint32_t right = build_node(first + half, count - half);
+	nodes[index].right_or_first = right;
+	nodes[index].count = 0;
+	return index;
+}
+
+namespace {
+	// slab test against (0, t_max)
+	inline bool hit_box(const glm::vec3& lo, const glm::vec3& hi, const glm::vec3& origin, const glm::vec3& inv_dir, float t_max)
+	{
+		glm::vec3 t0 = (lo - origin) * inv_dir;
+		glm::vec3 t1 = (hi - origin) * inv_dir;
+		glm::vec3 tmin = glm::min(t0, t1), tmax = glm::max(t0, t1);
+		float enter = glm::max(glm::max(tmin.x, tmin.y), glm::max(tmin.z, 0.0f));
+		float exit = glm::min(glm::min(tmax.x, tmax.y), glm::min(tmax.z, t_max));
+		return enter <= exit;
+	}
+
+	// Moeller-Trumbore, both sides
+	inline bool hit_triangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& origin, const glm::vec3& direction, float& t)
+	{
+		const float epsilon = 1e-7f;
+		glm::vec3 e1 = v1 - v0, e2 = v2 - v0;
+		glm::vec3 p = glm::cross(direction, e2);
+		float det = glm::dot(e1, p);
+		if (std::abs(det) < epsilon)
+			return false;
+
+		float inv_det = 1.0f / det;
+		glm::vec3 s = origin - v0;
+		float u = glm::dot(s, p) * inv_det;
+		if (u < 0.0f || u > 1.0f)
+			return false;
+
+		glm::vec3 q = glm::cross(s, e1);
+		float v = glm::dot(direction, q) * inv_det;
+		if (v < 0.0f || u + v > 1.0f)
+			return false;
+
+		t = glm::dot(e2, q) * inv_det;
+		return t > epsilon;
+	}
+}
+
+template <bool any_hit>
+bool TriangleBvh::traverse(const glm::vec3& origin, const glm::vec3& direction, float t_max, float& t, std::uint32_t& triangle) const
+{
+	if (nodes.empty())
+		return false;
+
+	glm::vec3 inv_dir = 1.0f / direction;
+	bool found = false;
+	float closest = t_max;
+
+	std::uint32_t stack[64];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = nodes[stack[--top]];
+		if (!hit_box(node.lo, node.hi, origin, inv_dir, closest))
+			continue;
+
+		if (node.count == 0) {
+			std::uint32_t self = static_cast<std::uint32_t>(&node - nodes.data());
+			stack[top++] = node.right_or_first;
+			stack[top++] = self + 1;
+			continue;
+		}
+
+		for (std::uint32_t i = node.right_or_first; i < node.right_or_first + node.count; ++i) {
+			std::uint32_t tri = order[i];
+			float hit_t;
+			if (hit_triangle(triangles[3 * tri], triangles[3 * tri + 1], triangles[3 * tri + 2], origin, direction, hit_t) && hit_t < closest) {
+				if (any_hit)
+					return true;
+				closest = hit_t;
+				triangle = tri;
+				found = true;
+			}
+		}
+	}
+	t = closest;
+	return found;
+}
+
+bool TriangleBvh::occluded(const glm::vec3& origin, const glm::vec3& direction, float t_max) const
+{
+	float t;
+	std::uint32_t triangle;
+	return traverse<true>(origin, direction, t_max, t, triangle);
+}
+
+bool TriangleBvh::intersect(const glm::vec3& origin, const glm::vec3& direction, float t_max, float& t, std::uint32_t& triangle) const
+{
+	return traverse<false>(origin, direction, t_max, t, triangle);
+}
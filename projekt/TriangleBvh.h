@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Bounding volume hierarchy over a static triangle soup, for CPU ray queries
+//
+// Built once by median split on the longest centroid axis, leaves hold up to
+// max_leaf_size triangles. Nodes are stored depth first, the left child directly
+// follows its parent. Queries are read only and safe to run from many threads.
+class TriangleBvh {
+public:
+	static constexpr unsigned int max_leaf_size = 4;
+
+	// three vertices per triangle
+	void build(const std::vector<glm::vec3>& vertices);
+
+	// any hit in (0, t_max), for shadow rays
+	bool occluded(const glm::vec3& origin, const glm::vec3& direction, float t_max) const;
+	// closest hit in (0, t_max); triangle is the index into the build() input
+	bool intersect(const glm::vec3& origin, const glm::vec3& direction, float t_max, float& t, std::uint32_t& triangle) const;
+
+	std::size_t node_count(void) const { return nodes.size(); }
+	std::size_t triangle_count(void) const { return order.size(); }
+
+private:
+	struct Node {
+		glm::vec3 lo;
+		std::uint32_t right_or_first; // inner: right child, leaf: first entry in order
+		glm::vec3 hi;
+		std::uint32_t count;          // 0 = inner node
+	};
+
+	std::uint32_t build_node(std::uint32_t first, std::uint32_t count);
+	template <bool any_hit>
+	bool traverse(const glm::vec3& origin, const glm::vec3& direction, float t_max, float& t, std::uint32_t& triangle) const;
+
+	std::vector<Node> nodes;
+	std::vector<std::uint32_t> order;   // triangle indices, leaves reference ranges
+	std::vector<glm::vec3> triangles;   // v0, v1, v2 in input order
+	std::vector<glm::vec3> centroids;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+
+// Lock-free single producer, single consumer handoff of the latest value
+//
+// The writer fills write_buffer() and publishes it, the reader calls update() and
+// reads read_buffer(). Three slots mean neither side ever waits: the writer always
+// has a slot of its own, the reader keeps its slot until it asks for a newer one,
+// and values published in between are overwritten, not queued.
+template<typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer<T>&) = delete;
+
+	// writer side
+	T& write_buffer(void) { return slots[back]; }
+	void publish(void) {
+		back = middle.exchange(back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+	}
+
+	// reader side; true if a value newer than read_buffer() was taken
+	bool update(void) {
+		if ((middle.load(std::memory_order_relaxed) & fresh_bit) == 0)
+			return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+		return true;
+	}
+	const T& read_buffer(void) const { return slots[front]; }
+
+private:
+	static constexpr unsigned int fresh_bit = 4;
+	static constexpr unsigned int index_mask = 3;
+
+	T slots[3];
+	unsigned int back = 0;                  // writer only
+	unsigned int front = 1;                 // reader only
+	std::atomic<unsigned int> middle = 2;   // index of the handoff slot | fresh_bit
+};
@@ -0,0 +1,61 @@
+#include "UniformGrid.h"
+
+void UniformGrid::cell_range(const Aabb& box, int& x0, int& z0, int& x1, int& z1) const
+{
+	// half-open cells: a box ending exactly on a cell border does not touch the next cell
+	x0 = static_cast<int>(std::floor((box.min.x - origin.x) * inv_cell));
+	z0 = static_cast<int>(std::floor((box.min.z - origin.y) * inv_cell));
+	x1 = static_cast<int>(std::ceil((box.max.x - origin.x) * inv_cell)) - 1;
+	z1 = static_cast<int>(std::ceil((box.max.z - origin.y) * inv_cell)) - 1;
+	x1 = std::max(x1, x0);
+	z1 = std::max(z1, z0);
+}
+
+void UniformGrid::build(const glm::vec2& grid_origin, int grid_cols, int grid_rows, float cell_size,
+	const std::vector<Aabb>& boxes, const std::vector<std::uint32_t>& ids)
+{
+	clear();
+	origin = grid_origin;
+	inv_cell = 1.0f / cell_size;
+	cols = grid_cols;
+	rows = grid_rows;
+
+	// pass 1: home cell of every item, count per cell
+	const std::uint32_t none = 0xFFFFFFFFu;
+	std::vector<std::uint32_t> home(boxes.size(), none);
+	cell_start.assign(static_cast<std::size_t>(cols) * rows + 1, 0);
+	for (std::size_t i = 0; i < boxes.size(); ++i) {
+		int x0, z0, x1, z1;
+		cell_range(boxes[i], x0, z0, x1, z1);
+		glm::vec3 c = boxes[i].center();
+		int cx = static_cast<int>(std::floor((c.x - origin.x) * inv_cell));
+		int cz = static_cast<int>(std::floor((c.z - origin.y) * inv_cell));
+		int item_reach = std::max(std::max(cx - x0, x1 - cx), std::max(cz - z0, z1 - cz));
+
+		if (cx < 0 || cz < 0 || cx >= cols || cz >= rows || item_reach > max_reach) {
+			global.push_back(ids[i]);
+			continue;
+		}
+		reach = std::max(reach, item_reach);
+		home[i] = static_cast<std::uint32_t>(cz * cols + cx);
+		cell_start[home[i] + 1]++;
+	}
+
+	// pass 2: prefix sum, then scatter
+	for (std::size_t c = 1; c < cell_start.size(); ++c)
+		cell_start[c] += cell_start[c - 1];
+	items.resize(cell_start.back());
+	std::vector<std::uint32_t> fill(cell_start.begin(), cell_start.end() - 1);
+	for (std::size_t i = 0; i < boxes.size(); ++i)
+		if (home[i] != none)
+			items[fill[home[i]]++] = ids[i];
+}
+
+void UniformGrid::clear(void)
+{
+	cols = rows = 0;
+	reach = 0;
+	cell_start.clear();
+	items.clear();
+	global.clear();
+}
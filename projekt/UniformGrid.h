@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Aabb.h"
+
+// Static 2D grid over the maze floor (x, z) for collision queries
+//
+// Cells match the maze map, one unit each. Every item is binned once, in the cell
+// of its center, and queries widen their cell range by the largest reach of an
+// item beyond its center cell (0 for the maze cubes), so nothing is reported
+// twice. Items are stored compactly: cell_start[c]..cell_start[c + 1] indexes the
+// item list of cell c, built with a counting pass and a prefix sum. Boxes that
+// cover too many cells or lie outside the grid, like the floor, go to a short list
+// that every query visits. Items are user ids, here EntityStore slots.
+class UniformGrid {
+public:
+	UniformGrid(void) = default;
+	UniformGrid(const UniformGrid&) = delete;
+
+	// cell (0, 0) starts at origin (x, z); boxes[i] is inserted with id ids[i]
+	void build(const glm::vec2& origin, int cols, int rows, float cell_size,
+		const std::vector<Aabb>& boxes, const std::vector<std::uint32_t>& ids);
+	void clear(void);
+
+	// calls fn(id) once for every item whose cells the box touches; returns the number of items visited
+	template<typename F>
+	unsigned int query(const Aabb& box, F&& fn) const;
+
+	unsigned int item_count(void) const { return static_cast<unsigned int>(items.size() + global.size()); }
+	unsigned int global_count(void) const { return static_cast<unsigned int>(global.size()); }
+	int columns(void) const { return cols; }
+	int rows_count(void) const { return rows; }
+
+	// an item reaching further than this from its center cell is not binned
+	static constexpr int max_reach = 2;
+
+private:
+	// inclusive cell range covered by a box, not clamped
+	void cell_range(const Aabb& box, int& x0, int& z0, int& x1, int& z1) const;
+
+	glm::vec2 origin = glm::vec2(0.0f);
+	float inv_cell = 1.0f;
+	int cols = 0, rows = 0;
+	int reach = 0; // cells
+
+	std::vector<std::uint32_t> cell_start; // cols * rows + 1
+	std::vector<std::uint32_t> items;
+	std::vector<std::uint32_t> global;     // visited by every query
+};
+
+template<typename F>
+unsigned int UniformGrid::query(const Aabb& box, F&& fn) const
+{
+	unsigned int visited = 0;
+	for (std::uint32_t id : global) {
+		fn(id);
+		++visited;
+	}
+
+	if (cols == 0 || rows == 0)
+		return visited;
+
+	int x0, z0, x1, z1;
+	cell_range(box, x0, z0, x1, z1);
+	x0 = std::max(x0 - reach, 0);
+	z0 = std::max(z0 - reach, 0);
+	x1 = std::min(x1 + reach, cols - 1);
+	z1 = std::min(z1 + reach, rows - 1);
+
+	// every item is binned in one cell only, no duplicates to filter
+	for (int z = z0; z <= z1; ++z) {
+		for (int x = x0; x <= x1; ++x) {
+			std::size_t c = static_cast<std::size_t>(z) * cols + x;
+			for (std::uint32_t k = cell_start[c]; k < cell_start[c + 1]; ++k) {
+				fn(items[k]);
+				++visited;
+			}
+		}
+	}
+	return visited;
+}
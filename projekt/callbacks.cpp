@@ -14,6 +14,7 @@ void App::glfw_framebuffer_size_callback(GLFWwindow* window, int width, int heig
 
 	inst->width = width;
 	inst->height = height;
+	inst->redraw_requested = true;
 
 	// set viewport
 	glViewport(0, 0, width, height);
@@ -25,6 +26,7 @@ void App::glfw_framebuffer_size_callback(GLFWwindow* window, int width, int heig
 void App::glfw_key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
 	auto inst = static_cast<App*>(glfwGetWindowUserPointer(window));
+	inst->redraw_requested = true; // movement keys are polled, any key event needs a frame
 	// || action == GLFW_REPEAT
 	if (action == GLFW_PRESS) {
 		switch (key) {
@@ -50,6 +52,26 @@ void App::glfw_key_callback(GLFWwindow* window, int key, int scancode, int actio
 			// switch tracker for flashlight
 			inst->trackFlashlight = !inst->trackFlashlight;
 			break;
+		case GLFW_KEY_G:
+			// switch GPU-driven rendering
+			inst->gpu_driven = !inst->gpu_driven;
+			std::cout << "GPU-driven rendering " << (inst->gpu_driven ? "on" : "off") << std::endl;
+			break;
+		case GLFW_KEY_Z:
+			// switch depth pre-pass
+			inst->depth_prepass = !inst->depth_prepass;
+			std::cout << "Depth pre-pass " << (inst->depth_prepass ? "on" : "off") << std::endl;
+			break;
+		case GLFW_KEY_N:
+			// switch dynamic resolution (R and F fly up and down)
+			inst->dynamic_resolution.enabled = !inst->dynamic_resolution.enabled;
+			std::cout << "Dynamic resolution " << (inst->dynamic_resolution.enabled ? "on" : "off") << std::endl;
+			break;
+		case GLFW_KEY_L:
+			// cycle frame pacing: unlimited, limited to target fps, render on demand
+			inst->frame_limiter.next_mode();
+			std::cout << "Frame pacing " << inst->frame_limiter.mode_name() << std::endl;
+			break;
 		default:
 			break;
 		}
@@ -66,6 +88,7 @@ void App::glfw_scroll_callback(GLFWwindow* window, double xoffset, double yoffse
 	inst->fov_degrees = std::clamp(inst->fov_degrees, 20.0f, 170.0f);
 
 	inst->update_projection_matrix();
+	inst->redraw_requested = true;
 }
 
 void App::mouse_callback(GLFWwindow* window, double xpos, double ypos)
@@ -84,6 +107,7 @@ void App::mouse_callback(GLFWwindow* window, double xpos, double ypos)
 	inst->yoffset = inst->lastY - ypos; // reversed since y-coordinates range from bottom to top
 	inst->lastX = xpos;
 	inst->lastY = ypos;
+	inst->redraw_requested = true;
 }
 
 void GLAPIENTRY App::MessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
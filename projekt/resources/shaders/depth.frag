@@ -0,0 +1,7 @@
+#version 430 core
+
+// Depth pre-pass, color writes are masked off; depth comes from fixed function
+
+void main()
+{
+}
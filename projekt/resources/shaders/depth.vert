@@ -0,0 +1,30 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in uint aInstance; // object index, selected by baseInstance of the draw
+
+// Depth pre-pass, position only; must produce bit-identical depth to obj.vert
+
+struct ObjectData {
+    mat4 model;
+    mat4 normal;
+    vec4 specular;
+    vec4 lightmapRect;
+    float shininess;
+    int textureLayer;
+    int lightmapLayer;
+    uint pad0;
+};
+
+layout (std430, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+uniform mat4 uVm = mat4(1.0);
+uniform mat4 uPm = mat4(1.0);
+
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = uPm * uVm * objects[aInstance].model * vec4(aPos, 1.0f);
+}
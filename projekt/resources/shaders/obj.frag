@@ -8,19 +8,29 @@ struct AmbientLight {
 
 uniform AmbientLight ambientLight;
 
+// Point lights, clustered, see ClusteredLights
 struct PointLight {
-    vec3 position;
-  
-    float constant;
-    float linear;
-    float quadratic; 
+    vec4 positionRadius;    // view space position, range
+    vec4 colorAmbient;      // diffuse and specular color, ambient factor
+    uint baked;             // already in the lightmap
+    uint pad0;
+    uint pad1;
+    uint pad2;
+};
 
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+layout (std430, binding = 3) readonly buffer Lights {
+    PointLight lights[];
 };
 
-uniform PointLight pointLight;
+layout (std430, binding = 4) readonly buffer Clusters {
+    uvec4 clusterGrid;      // tiles x, tiles y, depth slices
+    vec4 clusterParams;     // tile size in pixels, slice = log(depth) * z + w
+    uvec2 clusters[];       // offset into lightIndices, count
+};
+
+layout (std430, binding = 5) readonly buffer LightIndices {
+    uint lightIndices[];
+};
 
 struct SpotLight {
     vec3  position;
@@ -49,10 +59,28 @@ struct DirectionalLight{
 
 uniform DirectionalLight directionalLight;
 
-uniform vec4 specular_material;
-uniform float shininess;
+// material from ObjectBuffer, passed by obj.vert
+flat in vec4 specular_material;
+flat in float shininess;
+flat in int textureLayer; // -1 = sample ourTexture
 
 uniform sampler2D ourTexture;
+uniform sampler2DArray ourTextureArray;
+
+// static lighting (ambient, sun, baked point lights), irradiance without albedo
+uniform sampler2DArray lightmap;
+flat in int lightmapped;
+flat in int lightmapLayer;
+in vec2 lightmapUV;
+
+// sun shadows: cached map of the maze, per-frame map of moving objects
+uniform sampler2DShadow sunShadowStatic;
+uniform sampler2DShadow sunShadowDynamic;
+in vec4 shadowStaticCoord;
+in vec4 shadowDynamicCoord;
+
+// surface color, sampled once in main()
+vec4 albedo;
 
 uniform vec3 viewPos;
 
@@ -64,10 +92,10 @@ in vec3 fragPos;
 
 vec4 calculateAmbientLighting(AmbientLight light){
     // ambient
-    vec4 ambient = texture(ourTexture, texcoord) * vec4(light.ambient, 1.0);
+    vec4 ambient = albedo * vec4(light.ambient, 1.0);
  
     // diffuse
-    vec4 diffuse = texture(ourTexture, texcoord) * vec4(light.diffuse, 1.0);
+    vec4 diffuse = albedo * vec4(light.diffuse, 1.0);
 
     // specular
     vec4 specular = specular_material * vec4(light.specular, 1.0); 
@@ -76,23 +104,26 @@ vec4 calculateAmbientLighting(AmbientLight light){
 }
 
 vec4 calculatePointLighting(PointLight light, vec3 norm, vec3 fragPos, vec3 viewDir){
-    vec3 lightDir = normalize(light.position - fragPos);
+    vec3 position = light.positionRadius.xyz;
+    vec3 color = light.colorAmbient.rgb;
+    vec3 lightDir = normalize(position - fragPos);
 
     // ambient
-    vec4 ambient = texture(ourTexture, texcoord) * vec4(light.ambient, 1.0);
+    vec4 ambient = albedo * vec4(color * light.colorAmbient.a, 1.0);
  
     // diffuse 
     float diff = max(dot(norm, lightDir), 0.0);
-    vec4 diffuse = diff * texture(ourTexture, texcoord) * vec4(light.diffuse, 1.0);
+    vec4 diffuse = diff * albedo * vec4(color, 1.0);
 
     // specular
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
-    vec4 specular = specular_material * spec * vec4(light.specular, 1.0); 
+    vec4 specular = specular_material * spec * vec4(color, 1.0); 
     
-    // attenuation
-    float distance    = length(light.position - fragPos);
-    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    // attenuation, faded to zero at the light range so clusters can cut it off
+    float distance    = length(position - fragPos);
+    float window      = clamp(1.0 - pow(distance / light.positionRadius.w, 4.0), 0.0, 1.0);
+    float attenuation = window * window / (1.0 + 0.045 * distance + 0.0075 * (distance * distance));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -104,11 +135,11 @@ vec4 calculateSpotLighting(SpotLight light, vec3 norm, vec3 fragPos, vec3 viewDi
     vec3 lightDir = normalize(light.position - fragPos);
 
     // ambient
-    vec4 ambient = texture(ourTexture, texcoord) * vec4(light.ambient, 1.0);
+    vec4 ambient = albedo * vec4(light.ambient, 1.0);
  
     // diffuse 
     float diff = max(dot(norm, lightDir), 0.0);
-    vec4 diffuse = diff * texture(ourTexture, texcoord) * vec4(light.diffuse, 1.0);
+    vec4 diffuse = diff * albedo * vec4(light.diffuse, 1.0);
 
     // specular
     vec3 reflectDir = reflect(-lightDir, norm);
@@ -131,27 +162,51 @@ vec4 calculateSpotLighting(SpotLight light, vec3 norm, vec3 fragPos, vec3 viewDi
     return (ambient + diffuse + specular);
 }
 
-vec4 calculateDirectionalLighting(DirectionalLight light, vec3 norm, vec3 fragPos, vec3 viewDir){
+// 1 = lit, 4 hardware 2x2 PCF taps
+float shadowVisibility(sampler2DShadow map, vec4 coord){
+    vec3 c = coord.xyz / coord.w;
+    if (any(lessThan(c, vec3(0.0))) || any(greaterThan(c, vec3(1.0))))
+        return 1.0;
+
+    vec2 texel = 1.0 / vec2(textureSize(map, 0));
+    float visibility = 0.0;
+    visibility += texture(map, vec3(c.xy + vec2(-0.5, -0.5) * texel, c.z));
+    visibility += texture(map, vec3(c.xy + vec2( 0.5, -0.5) * texel, c.z));
+    visibility += texture(map, vec3(c.xy + vec2(-0.5,  0.5) * texel, c.z));
+    visibility += texture(map, vec3(c.xy + vec2( 0.5,  0.5) * texel, c.z));
+    return visibility * 0.25;
+}
+
+vec4 calculateDirectionalLighting(DirectionalLight light, vec3 norm, vec3 fragPos, vec3 viewDir, float visibility){
     vec3 lightDir = normalize(-light.direction);
 
     // ambient
-    vec4 ambient = texture(ourTexture, texcoord) * vec4(light.ambient, 1.0);
+    vec4 ambient = albedo * vec4(light.ambient, 1.0);
  
     // diffuse 
     float diff = max(dot(norm, lightDir), 0.0);
-    vec4 diffuse = diff * texture(ourTexture, texcoord) * vec4(light.diffuse, 1.0);
+    vec4 diffuse = diff * albedo * vec4(light.diffuse, 1.0);
 
     // specular
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
     vec4 specular = specular_material * spec * vec4(light.specular, 1.0); 
 
-    return (ambient + diffuse + specular);
+    return (ambient + visibility * (diffuse + specular));
+}
+
+uint clusterIndex(vec3 fragPos){
+    uint slice = uint(max(log(-fragPos.z) * clusterParams.z + clusterParams.w, 0.0));
+    uvec2 tile = uvec2(gl_FragCoord.xy / clusterParams.xy);
+    slice = min(slice, clusterGrid.z - 1);
+    tile = min(tile, clusterGrid.xy - 1);
+    return (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;
 }
 
 void main()
 {
     // properties
+    albedo = (textureLayer >= 0) ? texture(ourTextureArray, vec3(texcoord, textureLayer)) : texture(ourTexture, texcoord);
     vec3 norm = normalize(normal);
     vec3 viewDir = normalize(viewPos - fragPos);
 
@@ -159,13 +214,31 @@ void main()
     vec4 outputColor = vec4(0.0);
 
     // calculate all lighting
-    outputColor += calculateAmbientLighting(ambientLight);
-    outputColor += calculatePointLighting(pointLight, norm, fragPos, viewDir);
+    float sunStatic = shadowVisibility(sunShadowStatic, shadowStaticCoord);
+    float sunDynamic = shadowVisibility(sunShadowDynamic, shadowDynamicCoord);
+    if (lightmapped != 0) {
+        outputColor += albedo * vec4(texture(lightmap, vec3(lightmapUV, lightmapLayer)).rgb, 1.0);
+        // the baked sun already has static shadows, take it out where a moving object blocks it
+        float ndl = max(dot(norm, normalize(-directionalLight.direction)), 0.0);
+        outputColor -= albedo * vec4(directionalLight.diffuse * ndl * sunStatic * (1.0 - sunDynamic), 0.0);
+    }
+    else {
+        outputColor += calculateAmbientLighting(ambientLight);
+        outputColor += calculateDirectionalLighting(directionalLight, norm, fragPos, viewDir, min(sunStatic, sunDynamic));
+    }
+
+    // dynamic lights
+    uvec2 cluster = clusters[clusterIndex(fragPos)];
+    for (uint i = 0; i < cluster.y; ++i) {
+        PointLight light = lights[lightIndices[cluster.x + i]];
+        if (lightmapped != 0 && light.baked != 0u)
+            continue;
+        outputColor += calculatePointLighting(light, norm, fragPos, viewDir);
+    }
     outputColor += calculateSpotLighting(spotLight, norm, fragPos, viewDir);
-    outputColor += calculateDirectionalLighting(directionalLight, norm, fragPos, viewDir);    
 
     // Set the alpha channel from the texture
-    outputColor.a = texture(ourTexture, texcoord).a;
+    outputColor.a = albedo.a;
 
     FragColor = outputColor;
 }
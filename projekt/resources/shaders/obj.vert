@@ -2,22 +2,72 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexcoord;
 layout (location = 2) in vec3 aNormal;
+layout (location = 3) in uint aInstance; // object index, selected by baseInstance of the draw
+layout (location = 4) in vec2 aLightmapUV; // mesh chart, generated by the lightmap baker
 
-// Model, View, Projection matrices
-uniform mat4 uMm = mat4(1.0);
+// Per-object data, see ObjectBuffer
+struct ObjectData {
+    mat4 model;
+    mat4 normal; // transpose(inverse(uVm * model)), precomputed on CPU
+    vec4 specular;
+    vec4 lightmapRect;
+    float shininess;
+    int textureLayer;
+    int lightmapLayer;  // page of the lightmap atlas
+    uint pad0;
+};
+
+layout (std430, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// Sun shadow maps, see SunShadows
+layout (std430, binding = 6) readonly buffer Shadows {
+    mat4 sunStaticMatrix;   // world -> shadow map [0,1]
+    mat4 sunDynamicMatrix;
+};
+
+// View, Projection matrices
 uniform mat4 uVm = mat4(1.0);
 uniform mat4 uPm = mat4(1.0);
 
+// same depth as depth.vert, the color pass after a pre-pass tests with GL_EQUAL
+invariant gl_Position;
+
 out vec2 texcoord;
 out vec3 normal;
 out vec3 fragPos;
+out vec2 lightmapUV;
+out vec4 shadowStaticCoord;
+out vec4 shadowDynamicCoord;
+
+// material, constant per object
+flat out vec4 specular_material;
+flat out float shininess;
+flat out int textureLayer;
+flat out int lightmapped;
+flat out int lightmapLayer;
 
 void main()
-{	
+{
+    ObjectData obj = objects[aInstance];
+
     // Outputs the positions/coordinates of all vertices
-    gl_Position = uPm * uVm * uMm * vec4(aPos, 1.0f);
-    fragPos = vec3(uVm * uMm * vec4(aPos, 1.0));
+    gl_Position = uPm * uVm * obj.model * vec4(aPos, 1.0f);
+    fragPos = vec3(uVm * obj.model * vec4(aPos, 1.0));
     texcoord = aTexcoord;
-    normal = mat3(transpose(inverse(uVm * uMm))) * aNormal;
+    normal = mat3(obj.normal) * aNormal;
+
+    specular_material = obj.specular;
+    shininess = obj.shininess;
+    textureLayer = obj.textureLayer;
+
+    // chart placed into the atlas per object
+    lightmapUV = aLightmapUV * obj.lightmapRect.xy + obj.lightmapRect.zw;
+    lightmapped = (obj.lightmapRect.x > 0.0) ? 1 : 0;
+    lightmapLayer = obj.lightmapLayer;
 
-}
\ No newline at end of file
+    vec4 worldPos = obj.model * vec4(aPos, 1.0);
+    shadowStaticCoord = sunStaticMatrix * worldPos;
+    shadowDynamicCoord = sunDynamicMatrix * worldPos;
+}
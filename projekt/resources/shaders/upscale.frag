@@ -0,0 +1,35 @@
+#version 430 core
+
+// Upscale of the reduced resolution render with a clamped unsharp mask
+
+uniform sampler2D source;
+uniform vec2 uvScale;   // used part of the source texture
+uniform vec2 texelSize; // of the source texture
+uniform float sharpness;
+
+in vec2 uv;
+out vec4 FragColor;
+
+// texel centers of the rendered region only, the rest of the texture holds the clear color
+vec4 sampleRendered(vec2 st)
+{
+    return texture(source, clamp(st, 0.5 * texelSize, uvScale - 0.5 * texelSize));
+}
+
+void main()
+{
+    vec2 st = uv * uvScale;
+    vec4 center = sampleRendered(st);
+    vec4 n = sampleRendered(st + vec2(0.0, texelSize.y));
+    vec4 s = sampleRendered(st - vec2(0.0, texelSize.y));
+    vec4 e = sampleRendered(st + vec2(texelSize.x, 0.0));
+    vec4 w = sampleRendered(st - vec2(texelSize.x, 0.0));
+
+    // sharpen against the neighbourhood average, clamped to its range against halos
+    vec4 blurred = (n + s + e + w) * 0.25;
+    vec4 sharpened = center + sharpness * (center - blurred);
+    vec4 lo = min(center, min(min(n, s), min(e, w)));
+    vec4 hi = max(center, max(max(n, s), max(e, w)));
+
+    FragColor = vec4(clamp(sharpened, lo, hi).rgb, 1.0);
+}
@@ -0,0 +1,12 @@
+#version 430 core
+
+// Fullscreen triangle without vertex buffers
+
+out vec2 uv; // 0..1 over the window
+
+void main()
+{
+    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = p;
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}